@@ -0,0 +1,167 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPLaserQueryLibrary.h"
+#include "Game/SPGame/Skill/SPAbilityFunctionLibrary.h"
+#include "Game/SPGame/Character/SPGameCharacterBase.h"
+#include "Game/SPGame/Utils/SPGameLibrary.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("SP Laser Query"), STAT_SPLaserQuery, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP Laser Query Hits"), STAT_SPLaserQueryHits, STATGROUP_USPAbility);
+
+DEFINE_LOG_CATEGORY_STATIC(LogSPLaser, Log, All);
+
+void USPLaserQuery::Init(AActor* Owner, const FSPLaserQueryDesc& Desc)
+{
+	m_Desc = Desc;
+	m_Owner = Owner;
+	m_LastDamageTimes.Reset();
+
+	ISPActorInterface* SPOwner = Cast<ISPActorInterface>(Owner);
+	m_bOwnerIsSummon = SPOwner && SPOwner->GetSPActorType() == ESPActorType::Summon;
+	m_SummonMaster = m_bOwnerIsSummon ? SPOwner->GetMaster() : nullptr;
+}
+
+void USPLaserQuery::Query(const UAbleAbilityContext* Context, const FVector& TraceStart, const FRotator& Orientation, float Time, FSPLaserQueryResult& OutResult)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SPLaserQuery);
+
+	OutResult = FSPLaserQueryResult();
+
+	AActor* Owner = m_Owner.Get();
+	if (!Owner)
+	{
+		return;
+	}
+
+	TArray<FHitResult> HitResults;
+	USPAbilityFunctionLibrary::DoCollisionDetect(Context, Owner, HitResults, (ESPAbilityCollisionShape)m_Desc.CollisionShape, m_Desc.ObjectTypes, TraceStart, Orientation, true,
+		m_Desc.HalfExtents, m_Desc.Radius, m_Desc.ConeRadius, m_Desc.ConeLength, m_Desc.HalfHeight, m_Desc.CylinderAngle, m_Desc.CylinderInnerRadius, m_Desc.CylinderOuterRadius, m_Desc.CylinderHeight, m_Desc.bShowDebug, true, true, true);
+
+	USPAbilityFunctionLibrary::DoCollisionFilterByHitResult(m_Desc.Filters, Context, HitResults);
+
+	OutResult.NumHits = HitResults.Num();
+	INC_DWORD_STAT_BY(STAT_SPLaserQueryHits, HitResults.Num());
+	if (HitResults.Num() == 0)
+	{
+		return;
+	}
+
+	USPAbilityFunctionLibrary::SortHitResultsByImpactPointDistance(TraceStart, HitResults);
+
+	OutResult.bHit = true;
+	OutResult.FirstHit = HitResults[0];
+
+	// Only sweeping lasers go through what they hit.
+	const int32 NumCandidates = m_Desc.bSweeping ? HitResults.Num() : 1;
+	for (int32 Index = 0; Index < NumCandidates; ++Index)
+	{
+		const FHitResult& HitResult = HitResults[Index];
+		if (m_Desc.bVerbose)
+		{
+			UE_LOG(LogSPLaser, Log, TEXT("USPLaserQuery::Query Index: %d, Actor: %s"), Index, *GetNameSafe(HitResult.GetActor()));
+		}
+
+		if (ShouldSkipDamage(HitResult, Time))
+		{
+			continue;
+		}
+
+		OutResult.DamageCandidates.Add(HitResult);
+	}
+}
+
+void USPLaserQuery::MarkDamaged(const AActor* Actor, float Time)
+{
+	if (Actor)
+	{
+		m_LastDamageTimes.Add(FObjectKey(Actor), Time);
+	}
+}
+
+bool USPLaserQuery::ShouldSkipDamage(const FHitResult& HitResult, float Time) const
+{
+	AActor* HitActor = HitResult.GetActor();
+	if (!IsValid(HitActor))
+	{
+		return true;
+	}
+
+	if (m_Desc.Interval > 0.0f)
+	{
+		const float* LastDamageTime = m_LastDamageTimes.Find(FObjectKey(HitActor));
+		if (LastDamageTime && Time - *LastDamageTime < m_Desc.Interval)
+		{
+			return true;
+		}
+	}
+
+	if (!HitActor->CanBeDamaged())
+	{
+		return true;
+	}
+
+	ISPActorInterface* SPHitActor = Cast<ISPActorInterface>(HitActor);
+	if (SPHitActor && SPHitActor->GetIsDead())
+	{
+		return true;
+	}
+
+	AActor* Owner = m_Owner.Get();
+	if (m_bOwnerIsSummon)
+	{
+		// A summon never damages its master, nor optionally what it is attached to.
+		if (HitActor == m_SummonMaster.Get())
+		{
+			return true;
+		}
+
+		return m_Desc.bSkipSummonAttachmentActorDamage && Owner && HitActor == Owner->GetAttachParentActor();
+	}
+
+	if (SPHitActor && (SPHitActor->GetSPActorType() == ESPActorType::Player || SPHitActor->GetSPActorType() == ESPActorType::Pet))
+	{
+		return !m_Desc.bCheckSameTeam && !USPGameLibrary::IsInDifferentTeam(Owner, HitActor);
+	}
+
+	return false;
+}
+
+USPLaserQuery* USPLaserQueryLibrary::MakeLaserQuery(AActor* Owner, const FSPLaserQueryDesc& Desc)
+{
+	USPLaserQuery* LaserQuery = NewObject<USPLaserQuery>();
+	LaserQuery->Init(Owner, Desc);
+
+	// Nothing on the UE side references it, the Lua scratchpad only holds it in a table.
+	LaserQuery->AddToRoot();
+	return LaserQuery;
+}
+
+void USPLaserQueryLibrary::ReleaseLaserQuery(USPLaserQuery* LaserQuery)
+{
+	if (LaserQuery && LaserQuery->IsRooted())
+	{
+		LaserQuery->RemoveFromRoot();
+	}
+}
+
+void USPLaserQueryLibrary::DoLaserQuery(const UAbleAbilityContext* Context, USPLaserQuery* LaserQuery, const FVector& TraceStart, const FRotator& Orientation, float Time, FSPLaserQueryResult& OutResult)
+{
+	if (!LaserQuery)
+	{
+		UE_LOG(LogSPLaser, Warning, TEXT("USPLaserQueryLibrary::DoLaserQuery Failed, Invalid LaserQuery !"));
+		OutResult = FSPLaserQueryResult();
+		return;
+	}
+
+	LaserQuery->Query(Context, TraceStart, Orientation, Time, OutResult);
+}
+
+void USPLaserQueryLibrary::MarkDamaged(USPLaserQuery* LaserQuery, AActor* Actor, float Time)
+{
+	if (LaserQuery)
+	{
+		LaserQuery->MarkDamaged(Actor, Time);
+	}
+}
@@ -0,0 +1,163 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "UObject/ObjectKey.h"
+#include "SPLaserQueryLibrary.generated.h"
+
+class UAbleAbilityCollisionFilter;
+class UAbleAbilityContext;
+
+/* Everything a laser queries with, filled in once when the laser starts and handed to USPLaserQueryLibrary::MakeLaserQuery. */
+USTRUCT(BlueprintType)
+struct FEATURE_SP_API FSPLaserQueryDesc
+{
+	GENERATED_BODY()
+
+	/* ESPAbilityCollisionShape, as passed to USPAbilityFunctionLibrary::DoCollisionDetect. */
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	uint8 CollisionShape = 0;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	FVector HalfExtents = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float Radius = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float ConeRadius = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float ConeLength = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float HalfHeight = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float CylinderAngle = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float CylinderInnerRadius = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float CylinderOuterRadius = 0.0f;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float CylinderHeight = 0.0f;
+
+	/* The task's collision filters, run on every hit. */
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	TArray<UAbleAbilityCollisionFilter*> Filters;
+
+	/* Sweeping lasers damage everything they hit, others only the first hit. */
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	bool bSweeping = false;
+
+	/* Seconds before the same actor can be damaged again. 0 damages every query. */
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	float Interval = 0.0f;
+
+	/* Lets players and pets of the owner's team be damaged. */
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	bool bCheckSameTeam = false;
+
+	/* Summon owners don't damage the actor they are attached to. */
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	bool bSkipSummonAttachmentActorDamage = false;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	bool bShowDebug = false;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Laser")
+	bool bVerbose = false;
+};
+
+USTRUCT(BlueprintType)
+struct FEATURE_SP_API FSPLaserQueryResult
+{
+	GENERATED_BODY()
+
+	/* Number of hits left after the collision filters. */
+	UPROPERTY(BlueprintReadOnly, Category = "Laser")
+	int32 NumHits = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Laser")
+	bool bHit = false;
+
+	/* The hit nearest to the trace start, where the laser stops. */
+	UPROPERTY(BlueprintReadOnly, Category = "Laser")
+	FHitResult FirstHit;
+
+	/* The hits to damage this query, after the interval, death and actor type checks. */
+	UPROPERTY(BlueprintReadOnly, Category = "Laser")
+	TArray<FHitResult> DamageCandidates;
+};
+
+/**
+ * One running laser: its descriptor, what the owner is, and when each actor was last damaged.
+ * Lives natively for the whole laser so Lua only passes this handle each tick, not the descriptor.
+ */
+UCLASS(BlueprintType)
+class FEATURE_SP_API USPLaserQuery : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/* Resolves the owner's actor type and summon master once. */
+	void Init(AActor* Owner, const FSPLaserQueryDesc& Desc);
+
+	void Query(const UAbleAbilityContext* Context, const FVector& TraceStart, const FRotator& Orientation, float Time, FSPLaserQueryResult& OutResult);
+
+	/* Starts the damage interval of an actor the laser damaged. */
+	void MarkDamaged(const AActor* Actor, float Time);
+
+protected:
+	/* Returns true if the hit is still in its damage interval, dead, or an actor the owner must not damage. */
+	bool ShouldSkipDamage(const FHitResult& HitResult, float Time) const;
+
+	UPROPERTY()
+	FSPLaserQueryDesc m_Desc;
+
+	TWeakObjectPtr<AActor> m_Owner;
+
+	bool m_bOwnerIsSummon = false;
+
+	/* Only set for summons, which never damage their master. */
+	TWeakObjectPtr<AActor> m_SummonMaster;
+
+	/* Task time each actor was last damaged, set by MarkDamaged. */
+	TMap<FObjectKey, float> m_LastDamageTimes;
+};
+
+/**
+ * Native laser query for Ability_Task_Laser: collision, filters, sorting and damage checks in a single call,
+ * so only the first hit and the damage candidates reach Lua instead of every hit result.
+ */
+UCLASS()
+class FEATURE_SP_API USPLaserQueryLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/* Makes the query of a laser when it starts. It is kept alive until ReleaseLaserQuery, since Lua only holds it in a table. */
+	UFUNCTION(BlueprintCallable, Category = "SP|Laser")
+	static USPLaserQuery* MakeLaserQuery(AActor* Owner, const FSPLaserQueryDesc& Desc);
+
+	/* Lets a query made by MakeLaserQuery be garbage collected, once the laser ends. */
+	UFUNCTION(BlueprintCallable, Category = "SP|Laser")
+	static void ReleaseLaserQuery(USPLaserQuery* LaserQuery);
+
+	/* Queries the laser from TraceStart along Orientation. Time is the task time, used for the damage interval. */
+	UFUNCTION(BlueprintCallable, Category = "SP|Laser")
+	static void DoLaserQuery(const UAbleAbilityContext* Context, USPLaserQuery* LaserQuery, const FVector& TraceStart, const FRotator& Orientation, float Time, FSPLaserQueryResult& OutResult);
+
+	/* Call once damage was actually applied to the actor, so it is skipped for the laser's damage interval. Time is the task time. */
+	UFUNCTION(BlueprintCallable, Category = "SP|Laser")
+	static void MarkDamaged(USPLaserQuery* LaserQuery, AActor* Actor, float Time);
+};
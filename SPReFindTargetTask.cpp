@@ -1,134 +1,795 @@
-﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
-
-#include "Game/SPGame/Skill/Task/SPReFindTargetTask.h"
-#include "Game/SPGame/Utils/SPGameLibrary.h"
-
-#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
-
-USPReFindTargetTask::USPReFindTargetTask(const FObjectInitializer& Initializer)
-	: Super(Initializer), m_Targeting(nullptr)
-{
-}
-
-FString USPReFindTargetTask::GetModuleName_Implementation() const
-{
-	return TEXT("Feature.StarP.Script.System.Ability.Task.SPReFindTargetTask");
-}
-
-void USPReFindTargetTask::OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
-{
-	Super::OnTaskStart(Context);
-	OnTaskStartBP(Context.Get());
-}
-
-void USPReFindTargetTask::OnTaskStartBP_Implementation(const UAbleAbilityContext* Context) const
-{
-	if (bUseGroup)
-	{
-		FindTargetGroup(Context);
-	}
-	else
-	{
-		FindTarget(Context);
-	}
-}
-
-void USPReFindTargetTask::OnTaskTick(const TWeakObjectPtr<const UAbleAbilityContext>& Context, float deltaTime) const
-{
-	Super::OnTaskTick(Context, deltaTime);
-	OnTaskTickBP(Context.Get(), deltaTime);
-}
-
-void USPReFindTargetTask::OnTaskTickBP_Implementation(const UAbleAbilityContext* Context, float deltaTime) const
-{
-	if (bUseGroup)
-	{
-		FindTargetGroup(Context);
-	}
-	else
-	{
-		FindTarget(Context);
-	}
-}
-
-void USPReFindTargetTask::OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,
-                                    const EAbleAbilityTaskResult result) const
-{
-	Super::OnTaskEnd(Context, result);
-	OnTaskEndBP(Context.Get(), result);
-}
-
-void USPReFindTargetTask::OnTaskEndBP_Implementation(const UAbleAbilityContext* Context,
-                                                     const EAbleAbilityTaskResult result) const
-{
-}
-
-void USPReFindTargetTask::BindDynamicDelegates(UAbleAbility* Ability)
-{
-	Super::BindDynamicDelegates(Ability);
-}
-
-TStatId USPReFindTargetTask::GetStatId() const
-{
-	RETURN_QUICK_DECLARE_CYCLE_STAT(USPReFindTargetTask, STATGROUP_USPAbility);
-}
-
-bool USPReFindTargetTask::IsSingleFrameBP_Implementation() const
-{
-	return m_IsSingleFrame;
-}
-
-void USPReFindTargetTask::FindTarget(const UAbleAbilityContext* Context) const
-{
-	UAbleAbilityContext* AbilityContext = const_cast<UAbleAbilityContext*>(Context);
-	if (!AbilityContext)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("USPReFindTargetTask::FindTarget Failed, Invalid Context !"))
-			return;
-	}
-
-	if(m_Targeting)
-	{
-		if (m_Targeting->ShouldClearTargets())
-		{
-			AbilityContext->ClearTargetActors();
-		}
-		m_Targeting->FindTargets(*AbilityContext);
-	}
-}
-
-void USPReFindTargetTask::FindTargetGroup(const UAbleAbilityContext* Context) const
-{
-	UAbleAbilityContext* AbilityContext = const_cast<UAbleAbilityContext*>(Context);
-	if (!AbilityContext)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("USPReFindTargetTask::FindTargetGroup Failed, Invalid Context !"))
-		return;
-	}
-	
-	TArray<AActor*> ResultTargetActors;
-	for (const UAbleTargetingBase* TargetingRule : TargetingList)
-	{
-		if (TargetingRule)
-		{
-			//查找过滤，记录第一个对象
-			if (TargetingRule->ShouldClearTargets())
-			{
-				AbilityContext->ClearTargetActors();
-			}
-			TargetingRule->FindTargets(*AbilityContext);
-			AActor* ResultActor = GetSingleActorFromTargetType(Context, EAbleAbilityTargetType::ATT_TargetActor, 0);
-			ResultTargetActors.Add(ResultActor);
-		}
-	}
-
-	//最终结果存入TargetActors（结果与TargetingRule一一对应，结果存在为nullptr元素）
-	auto TargetActorsPtr = Context->GetTargetActorsWeakPtr();
-	TargetActorsPtr.Empty();
-	TargetActorsPtr.Append(ResultTargetActors);
-}
-
-EAbleAbilityTaskRealm USPReFindTargetTask::GetTaskRealmBP_Implementation() const
-{
-	return EAbleAbilityTaskRealm::ATR_ClientAndServer;
-}
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#include "Game/SPGame/Skill/Task/SPReFindTargetTask.h"
+#include "Game/SPGame/Skill/Task/SPTargetDeltaComponent.h"
+#include "Game/SPGame/Skill/Task/SPTargetingQueryCache.h"
+#include "Game/SPGame/Utils/SPGameLibrary.h"
+#include "ableSubSystem.h"
+#if !UE_BUILD_SHIPPING
+#include "ableAbility.h"
+#include "ableAbilityComponent.h"
+#include "Game/SPGame/Skill/Task/SPTargetingBenchmarkRules.h"
+#include "Components/SphereComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#endif
+
+#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSPTargeting, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP ReFind Target Queries"), STAT_SPReFindTargetQueries, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP ReFind Target Skipped Queries"), STAT_SPReFindTargetSkippedQueries, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP ReFind Target Unchanged Queries"), STAT_SPReFindTargetUnchangedQueries, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP ReFind Target Async Queries"), STAT_SPReFindTargetAsyncQueries, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP ReFind Target Shared Gathers"), STAT_SPReFindTargetSharedGathers, STATGROUP_USPAbility);
+DECLARE_CYCLE_STAT(TEXT("SP ReFind Target Async Evaluate"), STAT_SPReFindTargetAsyncEvaluate, STATGROUP_USPAbility);
+
+USPReFindTargetTask::USPReFindTargetTask(const FObjectInitializer& Initializer)
+	: Super(Initializer), m_Targeting(nullptr)
+{
+}
+
+FString USPReFindTargetTask::GetModuleName_Implementation() const
+{
+	return TEXT("Feature.StarP.Script.System.Ability.Task.SPReFindTargetTask");
+}
+
+void USPReFindTargetTask::OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
+{
+	Super::OnTaskStart(Context);
+	OnTaskStartBP(Context.Get());
+}
+
+void USPReFindTargetTask::OnTaskStartBP_Implementation(const UAbleAbilityContext* Context) const
+{
+	if (!Context)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("USPReFindTargetTask::OnTaskStartBP Failed, Invalid Context !"));
+		return;
+	}
+
+	USPReFindTargetTaskScratchPad* ScratchPad = Cast<USPReFindTargetTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (ScratchPad)
+	{
+		ScratchPad->SkippedQueries = 0;
+		ScratchPad->PendingQuery.Reset();
+		ScratchPad->PendingTask = UE::Tasks::FTask();
+	}
+
+	// The first targets are needed right away, so only later queries go async.
+	RunQuery(Context, ScratchPad);
+}
+
+void USPReFindTargetTask::OnTaskTick(const TWeakObjectPtr<const UAbleAbilityContext>& Context, float deltaTime) const
+{
+	Super::OnTaskTick(Context, deltaTime);
+	OnTaskTickBP(Context.Get(), deltaTime);
+}
+
+void USPReFindTargetTask::OnTaskTickBP_Implementation(const UAbleAbilityContext* Context, float deltaTime) const
+{
+	if (!Context)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("USPReFindTargetTask::OnTaskTickBP Failed, Invalid Context !"));
+		return;
+	}
+
+	USPReFindTargetTaskScratchPad* ScratchPad = Cast<USPReFindTargetTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (ScratchPad)
+	{
+		ScratchPad->TimeSinceQuery += deltaTime;
+		if (ScratchPad->PendingQuery.IsValid())
+		{
+			if (ScratchPad->PendingTask.IsCompleted())
+			{
+				CommitAsyncQuery(Context, *ScratchPad);
+			}
+			return;
+		}
+
+		if (CanKeepTargets(Context, *ScratchPad))
+		{
+			++ScratchPad->SkippedQueries;
+			INC_DWORD_STAT(STAT_SPReFindTargetSkippedQueries);
+			return;
+		}
+
+		if (CanQueryAsync())
+		{
+			LaunchAsyncQuery(Context, *ScratchPad);
+			return;
+		}
+	}
+
+	RunQuery(Context, ScratchPad);
+}
+
+bool USPReFindTargetTask::CanKeepTargets(const UAbleAbilityContext* Context, const USPReFindTargetTaskScratchPad& ScratchPad) const
+{
+	if (m_RetargetInterval <= 0.0f || ScratchPad.TimeSinceQuery >= m_RetargetInterval)
+	{
+		return false;
+	}
+
+	const AActor* SelfActor = Context->GetSelfActor();
+	const float HysteresisRangeSquared = FMath::Square(m_HysteresisRange);
+	for (const TWeakObjectPtr<AActor>& Target : ScratchPad.LastTargets)
+	{
+		// Empty group slots stay empty until the next query.
+		if (Target.IsExplicitlyNull())
+		{
+			continue;
+		}
+
+		const AActor* TargetActor = Target.Get();
+		if (!IsValid(TargetActor))
+		{
+			return false;
+		}
+
+		if (m_HysteresisRange > 0.0f && SelfActor && FVector::DistSquared(SelfActor->GetActorLocation(), TargetActor->GetActorLocation()) > HysteresisRangeSquared)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void USPReFindTargetTask::RunQuery(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad* ScratchPad) const
+{
+	INC_DWORD_STAT(STAT_SPReFindTargetQueries);
+
+	const TArray<TWeakObjectPtr<AActor>> PreviousTargets = Context->GetTargetActorsWeakPtr();
+	if (bUseGroup)
+	{
+		FindTargetGroup(Context);
+	}
+	else
+	{
+		FindTarget(Context);
+	}
+
+	ApplyTargetDelta(Context, ScratchPad, PreviousTargets);
+
+	if (ScratchPad)
+	{
+		ScratchPad->TimeSinceQuery = 0.0f;
+	}
+}
+
+void USPReFindTargetTask::DiffTargets(const TArray<TWeakObjectPtr<AActor>>& OldTargets, const TArray<TWeakObjectPtr<AActor>>& NewTargets, TArray<AActor*>& OutAdded, TArray<AActor*>& OutRemoved)
+{
+	for (const TWeakObjectPtr<AActor>& Target : NewTargets)
+	{
+		if (AActor* TargetActor = Target.Get())
+		{
+			if (!OldTargets.Contains(Target))
+			{
+				OutAdded.AddUnique(TargetActor);
+			}
+		}
+	}
+
+	for (const TWeakObjectPtr<AActor>& Target : OldTargets)
+	{
+		if (AActor* TargetActor = Target.Get())
+		{
+			if (!NewTargets.Contains(Target))
+			{
+				OutRemoved.AddUnique(TargetActor);
+			}
+		}
+	}
+}
+
+void USPReFindTargetTask::ApplyTargetDelta(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad* ScratchPad, const TArray<TWeakObjectPtr<AActor>>& PreviousTargets) const
+{
+	TArray<TWeakObjectPtr<AActor>>& TargetActors = const_cast<UAbleAbilityContext*>(Context)->GetMutableTargetActors();
+
+	TArray<AActor*> AddedTargets;
+	TArray<AActor*> RemovedTargets;
+	DiffTargets(PreviousTargets, TargetActors, AddedTargets, RemovedTargets);
+
+	const bool bUnchanged = AddedTargets.Num() == 0 && RemovedTargets.Num() == 0 && TargetActors.Num() == PreviousTargets.Num();
+	if (bUnchanged)
+	{
+		INC_DWORD_STAT(STAT_SPReFindTargetUnchangedQueries);
+
+		// Keep the order the targets already had, so nothing downstream sees a rebuilt list.
+		TargetActors = PreviousTargets;
+	}
+	else
+	{
+		OnTargetsChangedBP(Context, AddedTargets, RemovedTargets);
+
+		AActor* SelfActor = m_ReplicateTargetChanges ? Context->GetSelfActor() : nullptr;
+		if (SelfActor && SelfActor->HasAuthority() && SelfActor->GetIsReplicated() && SelfActor->GetNetMode() != NM_Standalone)
+		{
+			if (USPTargetDeltaComponent* DeltaComponent = USPTargetDeltaComponent::FindOrAdd(*SelfActor))
+			{
+				DeltaComponent->SendTargetsChanged(this, AddedTargets, RemovedTargets);
+			}
+		}
+	}
+
+	if (ScratchPad)
+	{
+		ScratchPad->LastTargets = TargetActors;
+	}
+}
+
+void USPReFindTargetTask::OnTargetsChangedBP_Implementation(const UAbleAbilityContext* Context, const TArray<AActor*>& AddedTargets, const TArray<AActor*>& RemovedTargets) const
+{
+}
+
+void FSPReFindTargetSpatialQuery::Evaluate()
+{
+	Results.SetNum(Shapes.Num());
+	for (int32 Index = 0; Index < Shapes.Num(); ++Index)
+	{
+		Shapes[Index].Evaluate(Candidates, Results[Index]);
+	}
+}
+
+bool USPReFindTargetTask::AreAllRulesSpatial() const
+{
+	// Every shape is resolved before any rule commits, so none may look from the targets an earlier rule is about to write.
+	const auto CanSnapshot = [](const UAbleTargetingBase* TargetingRule)
+	{
+		const USPTargetingSpatialQuery* SpatialRule = Cast<USPTargetingSpatialQuery>(TargetingRule);
+		return SpatialRule && !SpatialRule->DependsOnTargets();
+	};
+
+	if (!bUseGroup)
+	{
+		return CanSnapshot(m_Targeting);
+	}
+
+	for (const UAbleTargetingBase* TargetingRule : TargetingList)
+	{
+		if (TargetingRule && !CanSnapshot(TargetingRule))
+		{
+			return false;
+		}
+	}
+
+	return TargetingList.Num() > 0;
+}
+
+bool USPReFindTargetTask::SnapshotSpatialRules(const UAbleAbilityContext* Context, FSPReFindTargetSpatialQuery& OutQuery) const
+{
+	const UWorld* World = Context->GetWorld();
+	const USPTargetingSpatialIndex* SpatialIndex = World ? World->GetSubsystem<USPTargetingSpatialIndex>() : nullptr;
+	if (!SpatialIndex)
+	{
+		return false;
+	}
+
+	FBox2D Bounds(ForceInit);
+	const auto AddRule = [&](const UAbleTargetingBase* TargetingRule)
+	{
+		if (const USPTargetingSpatialQuery* SpatialRule = Cast<USPTargetingSpatialQuery>(TargetingRule))
+		{
+			Bounds += OutQuery.Shapes.Add_GetRef(SpatialRule->MakeShape(*Context)).GetBounds();
+			OutQuery.Rules.Add(SpatialRule);
+		}
+	};
+
+	if (bUseGroup)
+	{
+		for (const UAbleTargetingBase* TargetingRule : TargetingList)
+		{
+			AddRule(TargetingRule);
+		}
+	}
+	else
+	{
+		AddRule(m_Targeting);
+	}
+
+	// Rules of a group mostly look at the same area, so one gather over their union replaces a query per rule.
+	SpatialIndex->GatherCandidates(Bounds, OutQuery.Candidates);
+	return true;
+}
+
+void USPReFindTargetTask::CommitSpatialRules(const UAbleAbilityContext* Context, const FSPReFindTargetSpatialQuery& Query) const
+{
+	UAbleAbilityContext* AbilityContext = const_cast<UAbleAbilityContext*>(Context);
+
+	if (!bUseGroup)
+	{
+		if (Query.Rules.Num() > 0)
+		{
+			if (Query.Rules[0]->ShouldClearTargets())
+			{
+				AbilityContext->ClearTargetActors();
+			}
+			Query.Rules[0]->CommitTargets(*AbilityContext, Query.Results[0]);
+		}
+		return;
+	}
+
+	// Same as FindTargetGroup: each rule commits in turn, the context keeps what the last one left.
+	for (int32 Index = 0; Index < Query.Rules.Num(); ++Index)
+	{
+		if (Query.Rules[Index]->ShouldClearTargets())
+		{
+			AbilityContext->ClearTargetActors();
+		}
+		Query.Rules[Index]->CommitTargets(*AbilityContext, Query.Results[Index]);
+	}
+}
+
+bool USPReFindTargetTask::CanQueryAsync() const
+{
+	return m_AsyncTargeting && !m_IsSingleFrame && AreAllRulesSpatial();
+}
+
+void USPReFindTargetTask::LaunchAsyncQuery(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad& ScratchPad) const
+{
+	TSharedPtr<FSPReFindTargetSpatialQuery> Query = MakeShared<FSPReFindTargetSpatialQuery>();
+	if (!SnapshotSpatialRules(Context, *Query))
+	{
+		RunQuery(Context, &ScratchPad);
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_SPReFindTargetAsyncQueries);
+
+	// Only plain data crosses to the worker; actors are not touched until the commit.
+	ScratchPad.PendingTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Query]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SPReFindTargetAsyncEvaluate);
+		Query->Evaluate();
+	});
+
+	ScratchPad.PendingQuery = Query;
+	ScratchPad.TimeSinceQuery = 0.0f;
+}
+
+void USPReFindTargetTask::CommitAsyncQuery(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad& ScratchPad) const
+{
+	TSharedPtr<FSPReFindTargetSpatialQuery> Query = MoveTemp(ScratchPad.PendingQuery);
+	ScratchPad.PendingTask = UE::Tasks::FTask();
+
+	const TArray<TWeakObjectPtr<AActor>> PreviousTargets = Context->GetTargetActorsWeakPtr();
+	CommitSpatialRules(Context, *Query);
+	ApplyTargetDelta(Context, &ScratchPad, PreviousTargets);
+}
+
+void USPReFindTargetTask::OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,
+                                    const EAbleAbilityTaskResult result) const
+{
+	Super::OnTaskEnd(Context, result);
+	OnTaskEndBP(Context.Get(), result);
+}
+
+void USPReFindTargetTask::OnTaskEndBP_Implementation(const UAbleAbilityContext* Context,
+                                                     const EAbleAbilityTaskResult result) const
+{
+	if (USPReFindTargetTaskScratchPad* ScratchPad = Cast<USPReFindTargetTaskScratchPad>(Context->GetScratchPadForTask(this)))
+	{
+		// Scratch pads are pooled; a query still running finishes on its own and its results are dropped.
+		ScratchPad->PendingQuery.Reset();
+		ScratchPad->PendingTask = UE::Tasks::FTask();
+
+		if (ScratchPad->SkippedQueries > 0)
+		{
+			UE_LOG(LogSPTargeting, Verbose, TEXT("USPReFindTargetTask skipped %d queries in %s."), ScratchPad->SkippedQueries, *GetNameSafe(Context->GetAbility()));
+		}
+	}
+}
+
+void USPReFindTargetTask::BindDynamicDelegates(UAbleAbility* Ability)
+{
+	Super::BindDynamicDelegates(Ability);
+}
+
+UAbleAbilityTaskScratchPad* USPReFindTargetTask::CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const
+{
+	if (UAbleAbilityUtilitySubsystem* Subsystem = Context->GetUtilitySubsystem())
+	{
+		static TSubclassOf<UAbleAbilityTaskScratchPad> ScratchPadClass = USPReFindTargetTaskScratchPad::StaticClass();
+		return Subsystem->FindOrConstructTaskScratchPad(ScratchPadClass);
+	}
+
+	return NewObject<USPReFindTargetTaskScratchPad>(Context.Get());
+}
+
+TStatId USPReFindTargetTask::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USPReFindTargetTask, STATGROUP_USPAbility);
+}
+
+bool USPReFindTargetTask::IsSingleFrameBP_Implementation() const
+{
+	return m_IsSingleFrame;
+}
+
+void USPReFindTargetTask::FindTarget(const UAbleAbilityContext* Context) const
+{
+	UAbleAbilityContext* AbilityContext = const_cast<UAbleAbilityContext*>(Context);
+	if (!AbilityContext)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("USPReFindTargetTask::FindTarget Failed, Invalid Context !"))
+			return;
+	}
+
+	if(m_Targeting)
+	{
+		RunTargetingRule(*AbilityContext, *m_Targeting);
+	}
+}
+
+void USPReFindTargetTask::FindTargetGroup(const UAbleAbilityContext* Context) const
+{
+	UAbleAbilityContext* AbilityContext = const_cast<UAbleAbilityContext*>(Context);
+	if (!AbilityContext)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("USPReFindTargetTask::FindTargetGroup Failed, Invalid Context !"))
+		return;
+	}
+
+	if (AreAllRulesSpatial())
+	{
+		FSPReFindTargetSpatialQuery Query;
+		if (SnapshotSpatialRules(Context, Query))
+		{
+			INC_DWORD_STAT(STAT_SPReFindTargetSharedGathers);
+			Query.Evaluate();
+			CommitSpatialRules(Context, Query);
+			return;
+		}
+	}
+	
+	// Lua and Blueprint readers expect the full target list of the last rule, so the rules' results are not collapsed into slots.
+	for (const UAbleTargetingBase* TargetingRule : TargetingList)
+	{
+		if (TargetingRule)
+		{
+			RunTargetingRule(*AbilityContext, *TargetingRule);
+		}
+	}
+}
+
+void USPReFindTargetTask::RunTargetingRule(UAbleAbilityContext& Context, const UAbleTargetingBase& TargetingRule) const
+{
+	if (!TargetingRule.ShouldClearTargets())
+	{
+		TargetingRule.FindTargets(Context);
+		return;
+	}
+
+	Context.ClearTargetActors();
+
+	// Only spatial rules hand out their targets before filtering, which is what the cache shares; the filters run per caller.
+	const USPTargetingSpatialQuery* SpatialRule = Cast<USPTargetingSpatialQuery>(&TargetingRule);
+	const UWorld* World = Context.GetWorld();
+	USPTargetingQueryCache* QueryCache = SpatialRule && m_ShareResultsInFrame && World && USPTargetingQueryCache::IsEnabled() ? World->GetSubsystem<USPTargetingQueryCache>() : nullptr;
+	if (!QueryCache)
+	{
+		TargetingRule.FindTargets(Context);
+		return;
+	}
+
+	const FSPTargetingSpatialShape Shape = SpatialRule->MakeShape(Context);
+	AActor* Caller = Context.GetSelfActor();
+	if (const TArray<TWeakObjectPtr<AActor>>* CachedTargets = QueryCache->Find(*SpatialRule, Shape, Caller))
+	{
+		SpatialRule->CommitTargets(Context, *CachedTargets);
+		return;
+	}
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	TArray<TWeakObjectPtr<AActor>> Targets;
+	SpatialRule->QueryTargets(Context, Shape, Targets);
+	QueryCache->Add(*SpatialRule, Shape, Caller, Targets, FPlatformTime::Cycles() - StartCycles);
+	SpatialRule->CommitTargets(Context, Targets);
+}
+
+EAbleAbilityTaskRealm USPReFindTargetTask::GetTaskRealmBP_Implementation() const
+{
+	return EAbleAbilityTaskRealm::ATR_ClientAndServer;
+}
+
+#if !UE_BUILD_SHIPPING
+namespace SPReFindTargetBenchmark
+{
+	struct FSamples
+	{
+		TArray<double> Microseconds;
+
+		/* Malloc and Realloc calls of each query. Empty if the allocator doesn't count them. */
+		TArray<int64> Allocations;
+
+		FString ToJson() const
+		{
+			TArray<double> Sorted = Microseconds;
+			Sorted.Sort();
+			const auto Percentile = [&Sorted](float Fraction)
+			{
+				return Sorted.Num() > 0 ? Sorted[FMath::Clamp(FMath::CeilToInt(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1)] : 0.0;
+			};
+
+			double Total = 0.0;
+			for (const double Sample : Sorted)
+			{
+				Total += Sample;
+			}
+
+			const int32 Queries = FMath::Max(1, Sorted.Num());
+			FString Json = FString::Printf(TEXT("{ \"queries\": %d, \"p50_us\": %.3f, \"p99_us\": %.3f, \"mean_us\": %.3f"),
+				Sorted.Num(), Percentile(0.5f), Percentile(0.99f), Total / Queries);
+
+			if (Allocations.Num() > 0)
+			{
+				TArray<int64> SortedAllocations = Allocations;
+				SortedAllocations.Sort();
+				int64 TotalAllocations = 0;
+				for (const int64 Sample : SortedAllocations)
+				{
+					TotalAllocations += Sample;
+				}
+
+				Json += FString::Printf(TEXT(", \"p50_allocations\": %lld, \"max_allocations\": %lld, \"mean_allocations\": %.2f"),
+					SortedAllocations[SortedAllocations.Num() / 2], SortedAllocations.Last(), (double)TotalAllocations / SortedAllocations.Num());
+			}
+
+			return Json + TEXT(" }");
+		}
+	};
+
+	/* Malloc and Realloc calls the allocator counted so far, or -1 if it doesn't count them (needs STATS). */
+	int64 GetAllocationCalls()
+	{
+#if STATS
+		FGenericMemoryStats Stats;
+		GMalloc->GetAllocatorStats(Stats);
+		const SIZE_T* MallocCalls = Stats.Data.Find(TEXT("Total Malloc Calls"));
+		const SIZE_T* ReallocCalls = Stats.Data.Find(TEXT("Total Realloc Calls"));
+		if (MallocCalls && ReallocCalls)
+		{
+			return (int64)*MallocCalls + (int64)*ReallocCalls;
+		}
+#endif
+		return -1;
+	}
+
+	/* Makes the stock Able rule matching a spatial shape, so both run on the same targets. */
+	UAbleTargetingBase* MakeCollisionRule(UObject* Outer, ESPTargetingSpatialShape Shape)
+	{
+		switch (Shape)
+		{
+		case SPTargetingCone:
+			return NewObject<USPBenchmarkTargetingCone>(Outer);
+		case SPTargetingBox:
+			return NewObject<USPBenchmarkTargetingBox>(Outer);
+		default:
+			return NewObject<USPBenchmarkTargetingSphere>(Outer);
+		}
+	}
+}
+
+void USPReFindTargetTask::RunBenchmark(UWorld* World, const TArray<FString>& Args)
+{
+	using namespace SPReFindTargetBenchmark;
+
+	if (!World)
+	{
+		return;
+	}
+
+	USPTargetingSpatialIndex* SpatialIndex = World->GetSubsystem<USPTargetingSpatialIndex>();
+	if (!SpatialIndex)
+	{
+		UE_LOG(LogSPTargeting, Warning, TEXT("USPReFindTargetTask::RunBenchmark Failed, no targeting spatial index in %s !"), *World->GetName());
+		return;
+	}
+
+	TArray<FString> Values = Args;
+	const bool bQuit = Values.RemoveAll([](const FString& Arg) { return Arg.Equals(TEXT("-Quit"), ESearchCase::IgnoreCase); }) > 0;
+	const int32 NumTargets = Values.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Values[0])) : 1000;
+	const int32 NumCasters = Values.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Values[1])) : 50;
+	const int32 NumFrames = Values.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Values[2])) : 300;
+	const FString OutputFile = Values.Num() > 3 ? Values[3]
+		: FPaths::Combine(FPaths::ProfilingDir(), TEXT("SPTargeting"), FString::Printf(TEXT("ReFindTargetBenchmark-%s.json"), *FDateTime::Now().ToString()));
+	const float HalfSize = FMath::Sqrt((float)NumTargets) * 500.0f;
+
+	// Representative rules: a radius search on its own, and a radius / cone / box group,
+	// each once on the spatial index and once with the stock Able rules on collision.
+	const ESPTargetingSpatialShape GroupShapes[] = { SPTargetingRadius, SPTargetingCone, SPTargetingBox };
+	const auto MakeTasks = [&GroupShapes](bool bSpatial, USPReFindTargetTask*& OutSingleTask, USPReFindTargetTask*& OutGroupTask)
+	{
+		const auto MakeRule = [bSpatial](UObject* Outer, ESPTargetingSpatialShape Shape) -> UAbleTargetingBase*
+		{
+			if (!bSpatial)
+			{
+				return MakeCollisionRule(Outer, Shape);
+			}
+
+			USPTargetingSpatialQuery* Rule = NewObject<USPTargetingSpatialQuery>(Outer);
+			Rule->InitShape(Shape, 1500.0f, 45.0f, FVector(750.0f, 400.0f, 300.0f));
+			return Rule;
+		};
+
+		OutSingleTask = NewObject<USPReFindTargetTask>(GetTransientPackage());
+		OutSingleTask->m_Targeting = MakeRule(OutSingleTask, SPTargetingRadius);
+		OutSingleTask->AddToRoot();
+
+		OutGroupTask = NewObject<USPReFindTargetTask>(GetTransientPackage());
+		OutGroupTask->bUseGroup = true;
+		for (const ESPTargetingSpatialShape Shape : GroupShapes)
+		{
+			OutGroupTask->TargetingList.Add(MakeRule(OutGroupTask, Shape));
+		}
+		OutGroupTask->AddToRoot();
+	};
+
+	USPReFindTargetTask* SingleTask = nullptr;
+	USPReFindTargetTask* GroupTask = nullptr;
+	USPReFindTargetTask* CollisionSingleTask = nullptr;
+	USPReFindTargetTask* CollisionGroupTask = nullptr;
+	MakeTasks(true, SingleTask, GroupTask);
+	MakeTasks(false, CollisionSingleTask, CollisionGroupTask);
+
+	FRandomStream Random(NumTargets + NumCasters);
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	const auto SpawnActor = [&]()
+	{
+		// Pawn collision, so the stock rules find the same actors as the spatial index.
+		const FVector Location(Random.FRandRange(-HalfSize, HalfSize), Random.FRandRange(-HalfSize, HalfSize), 0.0f);
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FRotator(0.0f, Random.FRandRange(-180.0f, 180.0f), 0.0f), Location), SpawnParameters);
+		USphereComponent* Root = NewObject<USphereComponent>(Actor);
+		Root->InitSphereRadius(50.0f);
+		Root->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Root->SetCollisionObjectType(ECC_Pawn);
+		Root->SetCollisionResponseToAllChannels(ECR_Overlap);
+		Actor->SetRootComponent(Root);
+		Root->RegisterComponent();
+		Actor->SetActorLocation(Location);
+		SpatialIndex->RegisterActor(Actor);
+		return Actor;
+	};
+
+	TArray<TWeakObjectPtr<AActor>> Actors;
+	for (int32 Index = 0; Index < NumTargets; ++Index)
+	{
+		Actors.Add(SpawnActor());
+	}
+
+	TArray<UAbleAbilityContext*> Contexts;
+	for (int32 Index = 0; Index < NumCasters; ++Index)
+	{
+		AActor* Caster = SpawnActor();
+		UAbleAbilityComponent* AbilityComponent = NewObject<UAbleAbilityComponent>(Caster);
+		AbilityComponent->RegisterComponent();
+		// The stock rules read the Ability (dynamic properties, target type), so give them the CDO rather than nothing.
+		UAbleAbilityContext* Context = UAbleAbilityContext::MakeContext(GetDefault<UAbleAbility>(), AbilityComponent, Caster, Caster);
+		Context->AddToRoot();
+		Contexts.Add(Context);
+		Actors.Add(Caster);
+	}
+
+	TSharedRef<FSamples> SingleSamples = MakeShared<FSamples>();
+	TSharedRef<FSamples> GroupSamples = MakeShared<FSamples>();
+	TSharedRef<FSamples> CollisionSingleSamples = MakeShared<FSamples>();
+	TSharedRef<FSamples> CollisionGroupSamples = MakeShared<FSamples>();
+	for (FSamples* Samples : { &SingleSamples.Get(), &GroupSamples.Get(), &CollisionSingleSamples.Get(), &CollisionGroupSamples.Get() })
+	{
+		Samples->Microseconds.Reserve(NumCasters * NumFrames);
+		Samples->Allocations.Reserve(NumCasters * NumFrames);
+	}
+
+	UE_LOG(LogSPTargeting, Log, TEXT("USPReFindTargetTask::RunBenchmark %d targets, %d casters, %d frames."), NumTargets, NumCasters, NumFrames);
+
+	// Counting allocates too (the stats map), so take what an empty bracket counts off every query.
+	int64 CountOverhead = 0;
+	const int64 FirstCount = GetAllocationCalls();
+	if (FirstCount >= 0)
+	{
+		CountOverhead = GetAllocationCalls() - FirstCount;
+	}
+	else
+	{
+		UE_LOG(LogSPTargeting, Log, TEXT("USPReFindTargetTask::RunBenchmark the allocator doesn't count calls in this build, allocations are left out of the report."));
+	}
+
+	int32 Frame = 0;
+	TWeakObjectPtr<UWorld> WeakWorld = World;
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([=](float DeltaTime) mutable
+	{
+		// Every caster runs the same query back to back. Allocations are counted outside the timed part, they are process wide, so other threads add a little noise.
+		// Run with -llm or -trace=memory to break the allocations down, they are tagged SPTargeting/Benchmark.
+		const auto TimeQueries = [&Contexts, CountOverhead](FSamples& Samples, const TFunctionRef<void(UAbleAbilityContext*)> Query)
+		{
+			LLM_SCOPE_BYNAME(TEXT("SPTargeting/Benchmark"));
+			for (UAbleAbilityContext* Context : Contexts)
+			{
+				const int64 StartAllocations = GetAllocationCalls();
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				Query(Context);
+				const uint64 EndCycles = FPlatformTime::Cycles64();
+				const int64 EndAllocations = GetAllocationCalls();
+
+				Samples.Microseconds.Add(FPlatformTime::ToSeconds64(EndCycles - StartCycles) * 1.0e6);
+				if (StartAllocations >= 0)
+				{
+					Samples.Allocations.Add(FMath::Max<int64>(0, EndAllocations - StartAllocations - CountOverhead));
+				}
+			}
+		};
+
+		const bool bWorldValid = WeakWorld.IsValid();
+		if (bWorldValid && Frame < NumFrames)
+		{
+			// Keep everything moving, so the spatial index does its usual incremental work between queries.
+			for (const TWeakObjectPtr<AActor>& Actor : Actors)
+			{
+				if (AActor* ActorPtr = Actor.Get())
+				{
+					ActorPtr->AddActorWorldOffset(FVector(Random.FRandRange(-50.0f, 50.0f), Random.FRandRange(-50.0f, 50.0f), 0.0f));
+				}
+			}
+
+			TimeQueries(*SingleSamples, [&](UAbleAbilityContext* Context) { SingleTask->FindTarget(Context); });
+			TimeQueries(*GroupSamples, [&](UAbleAbilityContext* Context) { GroupTask->FindTargetGroup(Context); });
+			TimeQueries(*CollisionSingleSamples, [&](UAbleAbilityContext* Context) { CollisionSingleTask->FindTarget(Context); });
+			TimeQueries(*CollisionGroupSamples, [&](UAbleAbilityContext* Context) { CollisionGroupTask->FindTargetGroup(Context); });
+
+			++Frame;
+			return true;
+		}
+
+		const FString Report = FString::Printf(TEXT("{\n\t\"targets\": %d,\n\t\"casters\": %d,\n\t\"frames\": %d,\n\t\"find_target\": %s,\n\t\"find_target_group\": %s,\n\t\"find_target_collision\": %s,\n\t\"find_target_group_collision\": %s\n}\n"),
+			NumTargets, NumCasters, Frame, *SingleSamples->ToJson(), *GroupSamples->ToJson(), *CollisionSingleSamples->ToJson(), *CollisionGroupSamples->ToJson());
+		if (bWorldValid && Frame == NumFrames && FFileHelper::SaveStringToFile(Report, *OutputFile))
+		{
+			UE_LOG(LogSPTargeting, Log, TEXT("USPReFindTargetTask::RunBenchmark wrote %s:\n%s"), *OutputFile, *Report);
+		}
+		else
+		{
+			UE_LOG(LogSPTargeting, Warning, TEXT("USPReFindTargetTask::RunBenchmark Failed after %d of %d frames, could not write %s !"), Frame, NumFrames, *OutputFile);
+		}
+
+		for (UAbleAbilityContext* Context : Contexts)
+		{
+			Context->RemoveFromRoot();
+		}
+		for (USPReFindTargetTask* Task : { SingleTask, GroupTask, CollisionSingleTask, CollisionGroupTask })
+		{
+			Task->RemoveFromRoot();
+		}
+
+		if (USPTargetingSpatialIndex* Index = bWorldValid ? WeakWorld->GetSubsystem<USPTargetingSpatialIndex>() : nullptr)
+		{
+			for (const TWeakObjectPtr<AActor>& Actor : Actors)
+			{
+				if (AActor* ActorPtr = Actor.Get())
+				{
+					Index->UnregisterActor(ActorPtr);
+					ActorPtr->Destroy();
+				}
+			}
+		}
+
+		if (bQuit)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+		return false;
+	}));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SPTargetingBenchmarkReFindTargetCommand(
+	TEXT("SP.Targeting.BenchmarkReFindTarget"),
+	TEXT("SP.Targeting.BenchmarkReFindTarget [NumTargets=1000] [NumCasters=50] [NumFrames=300] [OutputFile] [-Quit]. Times FindTarget and FindTargetGroup with spatial rules and with the stock Able collision rules over several frames, and writes p50/p99 query times and allocations per query as json (Saved/Profiling/SPTargeting by default). Runs headless, e.g. -nullrhi -ExecCmds=\"SP.Targeting.BenchmarkReFindTarget 1000 50 300 -Quit\"."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&USPReFindTargetTask::RunBenchmark));
+#endif
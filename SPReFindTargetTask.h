@@ -1,84 +1,195 @@
-﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
-
-#pragma once
-
-#include "UnLuaInterface.h"
-#include "CoreMinimal.h"
-#include "Tasks/IAbleAbilityTask.h"
-#include "SPReFindTargetTask.generated.h"
-
-#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
-
-/**
- * 
- */
-UCLASS()
-class FEATURE_SP_API USPReFindTargetTask : public UAbleAbilityTask, public IUnLuaInterface
-{
-	GENERATED_BODY()
-
-protected:
-	virtual FString GetModuleName_Implementation() const override;
-	
-public:
-	USPReFindTargetTask(const FObjectInitializer& Initializer);
-
-	virtual void OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskStart"))
-	void OnTaskStartBP(const UAbleAbilityContext* Context) const;
-
-	virtual void OnTaskTick(const TWeakObjectPtr<const UAbleAbilityContext>& Context, float deltaTime) const override;
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskTick"))
-	void OnTaskTickBP(const UAbleAbilityContext* Context, float deltaTime) const;
-
-	virtual void OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,
-	                       const EAbleAbilityTaskResult result) const override;
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskEnd"))
-	void OnTaskEndBP(const UAbleAbilityContext* Context,
-					 const EAbleAbilityTaskResult result) const;
-
-	virtual bool IsSingleFrame() const override { return IsSingleFrameBP(); }
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "IsSingleFrame"))
-	bool IsSingleFrameBP() const;
-
-	void FindTarget(const UAbleAbilityContext* Context) const;
-	void FindTargetGroup(const UAbleAbilityContext* Context) const;
-
-	virtual bool IsAsyncFriendly() const override { return false; }
-
-	virtual void BindDynamicDelegates(UAbleAbility* Ability) override;
-
-	virtual EAbleAbilityTaskRealm GetTaskRealm() const override { return GetTaskRealmBP(); }
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "GetTaskRealm"))
-	EAbleAbilityTaskRealm GetTaskRealmBP() const;
-
-	virtual TStatId GetStatId() const override;
-
-#if WITH_EDITOR
-
-	virtual FText GetTaskCategory() const override { return LOCTEXT("USPReFindTargetTask", "Target"); }
-
-	virtual FText GetTaskName() const override { return LOCTEXT("USPReFindTargetTask", "Find Target"); }
-
-#endif
-
-protected:
-	UPROPERTY(EditAnywhere, Instanced, Category = "Targeting", meta = (DisplayName = "Target Logic", EditCondition = "!bUseGroup", EditConditionHides))
-	UAbleTargetingBase* m_Targeting;
-
-	UPROPERTY(EditAnywhere, Instanced, Category = "Targeting", meta = (DisplayName = "Target Group Logic", EditCondition = "bUseGroup", EditConditionHides))
-	TArray<UAbleTargetingBase*> TargetingList;
-
-	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "多类型查找目标"))
-	bool bUseGroup = false;
-	
-	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "IsSingleFrame"))
-	bool m_IsSingleFrame = true;
-};
-
-#undef LOCTEXT_NAMESPACE
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#pragma once
+
+#include "UnLuaInterface.h"
+#include "CoreMinimal.h"
+#include "Tasks/IAbleAbilityTask.h"
+#include "Tasks/Task.h"
+#include "Game/SPGame/Skill/Task/SPTargetingSpatialIndex.h"
+#include "Game/SPGame/Skill/Task/SPTargetingSpatialQuery.h"
+#include "SPReFindTargetTask.generated.h"
+
+#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
+
+/* A snapshot of spatial targeting rules and the candidates they share, gathered once over the union of their shapes. */
+struct FSPReFindTargetSpatialQuery
+{
+	/* One entry per rule, in rule order. */
+	TArray<const USPTargetingSpatialQuery*> Rules;
+
+	TArray<FSPTargetingSpatialShape> Shapes;
+
+	TArray<FSPTargetingCandidate> Candidates;
+
+	/* The targets of each rule, written by Evaluate. */
+	TArray<TArray<TWeakObjectPtr<AActor>>> Results;
+
+	/* Tests every rule's shape against the shared candidates. Safe on any thread. */
+	void Evaluate();
+};
+
+UCLASS(Transient)
+class FEATURE_SP_API USPReFindTargetTaskScratchPad : public UAbleAbilityTaskScratchPad
+{
+	GENERATED_BODY()
+public:
+	/* Time since the last full query. */
+	UPROPERTY(transient)
+	float TimeSinceQuery = 0.0f;
+
+	/* The targets the last full query found. */
+	UPROPERTY(transient)
+	TArray<TWeakObjectPtr<AActor>> LastTargets;
+
+	/* Queries skipped because the targets were still good. */
+	UPROPERTY(transient)
+	int32 SkippedQueries = 0;
+
+	/* The async query in flight, committed on the first tick after it finishes. */
+	TSharedPtr<FSPReFindTargetSpatialQuery> PendingQuery;
+
+	UE::Tasks::FTask PendingTask;
+};
+
+/**
+ * 
+ */
+UCLASS()
+class FEATURE_SP_API USPReFindTargetTask : public UAbleAbilityTask, public IUnLuaInterface
+{
+	GENERATED_BODY()
+
+protected:
+	virtual FString GetModuleName_Implementation() const override;
+	
+public:
+	USPReFindTargetTask(const FObjectInitializer& Initializer);
+
+	virtual void OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskStart"))
+	void OnTaskStartBP(const UAbleAbilityContext* Context) const;
+
+	virtual void OnTaskTick(const TWeakObjectPtr<const UAbleAbilityContext>& Context, float deltaTime) const override;
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskTick"))
+	void OnTaskTickBP(const UAbleAbilityContext* Context, float deltaTime) const;
+
+	virtual void OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,
+	                       const EAbleAbilityTaskResult result) const override;
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskEnd"))
+	void OnTaskEndBP(const UAbleAbilityContext* Context,
+					 const EAbleAbilityTaskResult result) const;
+
+	virtual bool IsSingleFrame() const override { return IsSingleFrameBP(); }
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "IsSingleFrame"))
+	bool IsSingleFrameBP() const;
+
+	void FindTarget(const UAbleAbilityContext* Context) const;
+	void FindTargetGroup(const UAbleAbilityContext* Context) const;
+
+	/* Runs one rule, reusing the targets of an identical query this frame when results are shared. */
+	void RunTargetingRule(UAbleAbilityContext& Context, const UAbleTargetingBase& TargetingRule) const;
+
+	/* Returns true if the targets of the last query can be kept instead of querying again this tick. */
+	bool CanKeepTargets(const UAbleAbilityContext* Context, const USPReFindTargetTaskScratchPad& ScratchPad) const;
+
+	/* Runs the full query and remembers its result. */
+	void RunQuery(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad* ScratchPad) const;
+
+	/* Appends the targets of NewTargets missing from OldTargets to OutAdded, and those of OldTargets missing from NewTargets to OutRemoved. Null targets are ignored. */
+	static void DiffTargets(const TArray<TWeakObjectPtr<AActor>>& OldTargets, const TArray<TWeakObjectPtr<AActor>>& NewTargets, TArray<AActor*>& OutAdded, TArray<AActor*>& OutRemoved);
+
+	/* Compares the targets of a query with the ones before it. Puts the old array back if nothing changed, otherwise reports the change. */
+	void ApplyTargetDelta(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad* ScratchPad, const TArray<TWeakObjectPtr<AActor>>& PreviousTargets) const;
+
+	/**
+	 * Called when a query changes the targets. Not called when a query finds the same targets again, nor on ticks that keep
+	 * the targets without querying (Retarget Interval); those ticks count as skipped queries, not unchanged ones.
+	 * With Replicate Target Changes, the server's changes also reach clients through USPTargetDeltaComponent::OnTargetsChanged.
+	 */
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTargetsChanged"))
+	void OnTargetsChangedBP(const UAbleAbilityContext* Context, const TArray<AActor*>& AddedTargets, const TArray<AActor*>& RemovedTargets) const;
+
+	/* Returns true if every rule is a spatial rule that doesn't look from the targets, so they can share one candidate gather. */
+	bool AreAllRulesSpatial() const;
+
+	/* Resolves every rule's shape and gathers their candidates once. Returns false if there is no spatial index. */
+	bool SnapshotSpatialRules(const UAbleAbilityContext* Context, FSPReFindTargetSpatialQuery& OutQuery) const;
+
+	/* Writes the targets of an evaluated query to the context, running the rules' filters. */
+	void CommitSpatialRules(const UAbleAbilityContext* Context, const FSPReFindTargetSpatialQuery& Query) const;
+
+	/* Returns true if re-queries should run off the game thread. */
+	bool CanQueryAsync() const;
+
+	/* Snapshots the candidates of every rule and evaluates them on a worker thread. */
+	void LaunchAsyncQuery(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad& ScratchPad) const;
+
+	/* Writes the targets of a finished async query to the context, running the rules' filters. */
+	void CommitAsyncQuery(const UAbleAbilityContext* Context, USPReFindTargetTaskScratchPad& ScratchPad) const;
+
+	virtual bool IsAsyncFriendly() const override { return false; }
+
+	virtual void BindDynamicDelegates(UAbleAbility* Ability) override;
+
+	virtual EAbleAbilityTaskRealm GetTaskRealm() const override { return GetTaskRealmBP(); }
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "GetTaskRealm"))
+	EAbleAbilityTaskRealm GetTaskRealmBP() const;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual UAbleAbilityTaskScratchPad* CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const override;
+
+#if !UE_BUILD_SHIPPING
+	/* Times FindTarget and FindTargetGroup for spawned casters and targets over several frames, and writes the result to a json file. See SP.Targeting.BenchmarkReFindTarget. */
+	static void RunBenchmark(UWorld* World, const TArray<FString>& Args);
+#endif
+
+#if WITH_EDITOR
+
+	virtual FText GetTaskCategory() const override { return LOCTEXT("USPReFindTargetTask", "Target"); }
+
+	virtual FText GetTaskName() const override { return LOCTEXT("USPReFindTargetTask", "Find Target"); }
+
+#endif
+
+protected:
+	UPROPERTY(EditAnywhere, Instanced, Category = "Targeting", meta = (DisplayName = "Target Logic", EditCondition = "!bUseGroup", EditConditionHides))
+	UAbleTargetingBase* m_Targeting;
+
+	UPROPERTY(EditAnywhere, Instanced, Category = "Targeting", meta = (DisplayName = "Target Group Logic", EditCondition = "bUseGroup", EditConditionHides))
+	TArray<UAbleTargetingBase*> TargetingList;
+
+	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "多类型查找目标"))
+	bool bUseGroup = false;
+	
+	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "IsSingleFrame"))
+	bool m_IsSingleFrame = true;
+
+	/* Seconds between full queries while the Task ticks. Targets are queried again sooner if one of them becomes invalid. 0 queries every tick. */
+	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "Retarget Interval", EditCondition = "!m_IsSingleFrame", ClampMin = 0))
+	float m_RetargetInterval = 0.0f;
+
+	/* Between queries, targets further than this from us are dropped (and queried again). 0 keeps targets at any distance. */
+	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "Hysteresis Range", EditCondition = "!m_IsSingleFrame", ClampMin = 0))
+	float m_HysteresisRange = 0.0f;
+
+	/* Re-queries on a worker thread while the Task ticks, keeping the current targets until the results arrive a frame later. Only used when every rule is an SP Targeting Spatial Query. */
+	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "Async Targeting", EditCondition = "!m_IsSingleFrame"))
+	bool m_AsyncTargeting = false;
+
+	/* Reuses the targets another caller of the same team found with the same spatial rule from about the same place this frame, before the rule's filters, which still run for each caller. Only for spatial rules that clear targets. */
+	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "Share Results In Frame"))
+	bool m_ShareResultsInFrame = false;
+
+	/* Sends the targets the server adds and removes to every client through a USPTargetDeltaComponent on the caster, only when they change. */
+	UPROPERTY(EditAnywhere, Category = "Targeting", meta = (DisplayName = "Replicate Target Changes"))
+	bool m_ReplicateTargetChanges = false;
+};
+
+#undef LOCTEXT_NAMESPACE
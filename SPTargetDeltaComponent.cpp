@@ -0,0 +1,49 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTargetDeltaComponent.h"
+#include "Game/SPGame/Skill/Task/SPReFindTargetTask.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP ReFind Target Deltas Sent"), STAT_SPReFindTargetDeltasSent, STATGROUP_USPAbility);
+
+USPTargetDeltaComponent::USPTargetDeltaComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+USPTargetDeltaComponent* USPTargetDeltaComponent::FindOrAdd(AActor& Actor)
+{
+	if (USPTargetDeltaComponent* Existing = Actor.FindComponentByClass<USPTargetDeltaComponent>())
+	{
+		return Existing;
+	}
+
+	USPTargetDeltaComponent* Component = NewObject<USPTargetDeltaComponent>(&Actor);
+	Component->RegisterComponent();
+	return Component;
+}
+
+void USPTargetDeltaComponent::SendTargetsChanged(const USPReFindTargetTask* Task, const TArray<AActor*>& AddedTargets, const TArray<AActor*>& RemovedTargets)
+{
+	const AActor* Owner = GetOwner();
+	if (!Owner || !Owner->HasAuthority() || !Owner->GetIsReplicated())
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_SPReFindTargetDeltasSent);
+	MulticastTargetsChanged(Task, AddedTargets, RemovedTargets);
+}
+
+void USPTargetDeltaComponent::MulticastTargetsChanged_Implementation(const USPReFindTargetTask* Task, const TArray<AActor*>& AddedTargets, const TArray<AActor*>& RemovedTargets)
+{
+	// The server already reported the change to its own Task.
+	if (GetNetMode() == NM_Client)
+	{
+		OnTargetsChanged.Broadcast(Task, AddedTargets, RemovedTargets);
+	}
+}
@@ -0,0 +1,39 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SPTargetDeltaComponent.generated.h"
+
+class USPReFindTargetTask;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FSPOnReplicatedTargetsChanged, const USPReFindTargetTask*, Task, const TArray<AActor*>&, AddedTargets, const TArray<AActor*>&, RemovedTargets);
+
+/**
+ * Sends the target changes a Find Target Task found on the server to every client, only when they change instead of the whole target list.
+ * Clients receive them through OnTargetsChanged, next to whatever their own copy of the Task reports locally.
+ * Added to casters on demand by USPReFindTargetTask (Replicate Target Changes).
+ */
+UCLASS(ClassGroup = (SP))
+class FEATURE_SP_API USPTargetDeltaComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USPTargetDeltaComponent(const FObjectInitializer& ObjectInitializer);
+
+	/* Returns the target delta component of the actor, adding it if needed. Server only. */
+	static USPTargetDeltaComponent* FindOrAdd(AActor& Actor);
+
+	/* Sends a change of the Task's targets to the clients. Server only. */
+	void SendTargetsChanged(const USPReFindTargetTask* Task, const TArray<AActor*>& AddedTargets, const TArray<AActor*>& RemovedTargets);
+
+	/* Broadcast on clients for every change the server sent. */
+	UPROPERTY(BlueprintAssignable, Category = "SP|Targeting")
+	FSPOnReplicatedTargetsChanged OnTargetsChanged;
+
+protected:
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastTargetsChanged(const USPReFindTargetTask* Task, const TArray<AActor*>& AddedTargets, const TArray<AActor*>& RemovedTargets);
+};
@@ -0,0 +1,29 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTargetingBenchmarkRules.h"
+
+// Same sizes as the USPTargetingSpatialQuery shapes the benchmark compares against, on the channel its actors use.
+
+USPBenchmarkTargetingSphere::USPBenchmarkTargetingSphere(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	m_Radius = 1500.0f;
+	m_CollisionChannels = { ECC_Pawn };
+}
+
+USPBenchmarkTargetingCone::USPBenchmarkTargetingCone(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	m_FOV = 90.0f;
+	m_Length = 1500.0f;
+	m_Height = 600.0f;
+	m_CollisionChannels = { ECC_Pawn };
+}
+
+USPBenchmarkTargetingBox::USPBenchmarkTargetingBox(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	m_HalfExtents = FVector(750.0f, 400.0f, 300.0f);
+	m_CollisionChannels = { ECC_Pawn };
+}
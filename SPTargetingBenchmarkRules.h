@@ -0,0 +1,38 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Targeting/ableTargetingBox.h"
+#include "Targeting/ableTargetingCone.h"
+#include "Targeting/ableTargetingSphere.h"
+#include "SPTargetingBenchmarkRules.generated.h"
+
+/* Stock Able rules with the shapes of SP.Targeting.BenchmarkReFindTarget, set up in their constructors since the rules only expose them to the editor. Not for use in Abilities. */
+
+UCLASS(Transient, HideDropdown, NotBlueprintable)
+class FEATURE_SP_API USPBenchmarkTargetingSphere : public UAbleTargetingSphere
+{
+	GENERATED_BODY()
+
+public:
+	USPBenchmarkTargetingSphere(const FObjectInitializer& ObjectInitializer);
+};
+
+UCLASS(Transient, HideDropdown, NotBlueprintable)
+class FEATURE_SP_API USPBenchmarkTargetingCone : public UAbleTargetingCone
+{
+	GENERATED_BODY()
+
+public:
+	USPBenchmarkTargetingCone(const FObjectInitializer& ObjectInitializer);
+};
+
+UCLASS(Transient, HideDropdown, NotBlueprintable)
+class FEATURE_SP_API USPBenchmarkTargetingBox : public UAbleTargetingBox
+{
+	GENERATED_BODY()
+
+public:
+	USPBenchmarkTargetingBox(const FObjectInitializer& ObjectInitializer);
+};
@@ -0,0 +1,113 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTargetingQueryCache.h"
+#include "Game/SPGame/Skill/Task/SPTargetingSpatialQuery.h"
+#include "Game/SPGame/Utils/SPGameLibrary.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP Targeting Query Cache Hits"), STAT_SPTargetingQueryCacheHits, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP Targeting Query Cache Misses"), STAT_SPTargetingQueryCacheMisses, STATGROUP_USPAbility);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("SP Targeting Query Cache Saved Time (ms)"), STAT_SPTargetingQueryCacheSavedTime, STATGROUP_USPAbility);
+
+static TAutoConsoleVariable<bool> CVarSPTargetingQueryCacheEnable(
+	TEXT("SP.Targeting.QueryCache.Enable"),
+	true,
+	TEXT("Lets Find Target tasks that share results reuse the targets of an identical query in the same frame."));
+
+static TAutoConsoleVariable<float> CVarSPTargetingQueryCacheLocationTolerance(
+	TEXT("SP.Targeting.QueryCache.LocationTolerance"),
+	50.0f,
+	TEXT("Size of the grid query locations are snapped to before they are compared."));
+
+static TAutoConsoleVariable<float> CVarSPTargetingQueryCacheYawTolerance(
+	TEXT("SP.Targeting.QueryCache.YawTolerance"),
+	10.0f,
+	TEXT("Degrees query facings are snapped to before they are compared."));
+
+bool USPTargetingQueryCache::IsEnabled()
+{
+	return CVarSPTargetingQueryCacheEnable.GetValueOnGameThread();
+}
+
+const TArray<TWeakObjectPtr<AActor>>* USPTargetingQueryCache::Find(const USPTargetingSpatialQuery& Rule, const FSPTargetingSpatialShape& Shape, AActor* Caller)
+{
+	ResetIfNewFrame();
+
+	const FEntry* Entry = FindEntry(MakeKey(Rule, Shape), Caller);
+	if (!Entry)
+	{
+		INC_DWORD_STAT(STAT_SPTargetingQueryCacheMisses);
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_SPTargetingQueryCacheHits);
+	INC_FLOAT_STAT_BY(STAT_SPTargetingQueryCacheSavedTime, FPlatformTime::ToMilliseconds(Entry->QueryCycles));
+	return &Entry->Targets;
+}
+
+void USPTargetingQueryCache::Add(const USPTargetingSpatialQuery& Rule, const FSPTargetingSpatialShape& Shape, AActor* Caller, const TArray<TWeakObjectPtr<AActor>>& Targets, uint32 QueryCycles)
+{
+	ResetIfNewFrame();
+
+	const FKey Key = MakeKey(Rule, Shape);
+	FEntry* Entry = FindEntry(Key, Caller);
+	if (!Entry)
+	{
+		Entry = &m_Entries.FindOrAdd(Key).AddDefaulted_GetRef();
+		Entry->Caller = Caller;
+	}
+
+	Entry->Targets = Targets;
+	Entry->QueryCycles = QueryCycles;
+}
+
+USPTargetingQueryCache::FEntry* USPTargetingQueryCache::FindEntry(const FKey& Key, AActor* Caller)
+{
+	TArray<FEntry, TInlineAllocator<2>>* Entries = m_Entries.Find(Key);
+	if (!Entries)
+	{
+		return nullptr;
+	}
+
+	for (FEntry& Entry : *Entries)
+	{
+		AActor* EntryCaller = Entry.Caller.Get();
+		if (EntryCaller && Caller && !USPGameLibrary::IsInDifferentTeam(EntryCaller, Caller))
+		{
+			return &Entry;
+		}
+	}
+
+	return nullptr;
+}
+
+USPTargetingQueryCache::FKey USPTargetingQueryCache::MakeKey(const USPTargetingSpatialQuery& Rule, const FSPTargetingSpatialShape& Shape) const
+{
+	const FTransform& Transform = Shape.Transform;
+	const float LocationTolerance = FMath::Max(1.0f, CVarSPTargetingQueryCacheLocationTolerance.GetValueOnGameThread());
+	const float YawTolerance = FMath::Max(1.0f, CVarSPTargetingQueryCacheYawTolerance.GetValueOnGameThread());
+	const FVector Location = Transform.GetLocation() / LocationTolerance;
+
+	FKey Key;
+	Key.Rule = FObjectKey(&Rule);
+	Key.Location = FIntVector(FMath::RoundToInt(Location.X), FMath::RoundToInt(Location.Y), FMath::RoundToInt(Location.Z));
+
+	// A sphere looks the same from every direction, only cones and boxes need the yaw.
+	if (Shape.Shape != SPTargetingRadius)
+	{
+		// Wrap the last bucket around, so 359 and 0 degrees share one.
+		const int32 NumYawBuckets = FMath::Max(1, FMath::RoundToInt(360.0f / YawTolerance));
+		Key.Yaw = FMath::RoundToInt(FRotator::ClampAxis(Transform.Rotator().Yaw) / YawTolerance) % NumYawBuckets;
+	}
+	return Key;
+}
+
+void USPTargetingQueryCache::ResetIfNewFrame()
+{
+	if (m_Frame != GFrameCounter)
+	{
+		m_Frame = GFrameCounter;
+		m_Entries.Reset();
+	}
+}
@@ -0,0 +1,74 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "SPTargetingQueryCache.generated.h"
+
+class USPTargetingSpatialQuery;
+struct FSPTargetingSpatialShape;
+
+/**
+ * Spatial query results of the current frame, so the monsters of a pack running the same rule from about the same place share one query.
+ * Entries hold the targets before the rule's filters, which still run for every caller, and are only shared between callers of the same team.
+ * They are keyed by rule and the shape's transform, quantized by SP.Targeting.QueryCache.LocationTolerance and YawTolerance.
+ * Everything is dropped when the frame changes.
+ */
+UCLASS()
+class FEATURE_SP_API USPTargetingQueryCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static bool IsEnabled();
+
+	/* Returns the unfiltered targets Rule found this frame with a shape like Shape for a caller of the same team, or null. */
+	const TArray<TWeakObjectPtr<AActor>>* Find(const USPTargetingSpatialQuery& Rule, const FSPTargetingSpatialShape& Shape, AActor* Caller);
+
+	/* Remembers the unfiltered targets Rule found with Shape for Caller, and how many cycles the query took. */
+	void Add(const USPTargetingSpatialQuery& Rule, const FSPTargetingSpatialShape& Shape, AActor* Caller, const TArray<TWeakObjectPtr<AActor>>& Targets, uint32 QueryCycles);
+
+protected:
+	struct FKey
+	{
+		FObjectKey Rule;
+
+		FIntVector Location = FIntVector::ZeroValue;
+
+		int32 Yaw = 0;
+
+		friend bool operator==(const FKey& A, const FKey& B)
+		{
+			return A.Rule == B.Rule && A.Location == B.Location && A.Yaw == B.Yaw;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Rule), GetTypeHash(Key.Location)), GetTypeHash(Key.Yaw));
+		}
+	};
+
+	struct FEntry
+	{
+		/* The caller that ran the query, entries are shared with the callers of its team. */
+		TWeakObjectPtr<AActor> Caller;
+
+		TArray<TWeakObjectPtr<AActor>> Targets;
+
+		uint32 QueryCycles = 0;
+	};
+
+	FKey MakeKey(const USPTargetingSpatialQuery& Rule, const FSPTargetingSpatialShape& Shape) const;
+
+	/* Returns the entry of the key run by a caller of Caller's team, or null. */
+	FEntry* FindEntry(const FKey& Key, AActor* Caller);
+
+	void ResetIfNewFrame();
+
+	/* One entry per team that ran the query. */
+	TMap<FKey, TArray<FEntry, TInlineAllocator<2>>> m_Entries;
+
+	uint64 m_Frame = 0;
+};
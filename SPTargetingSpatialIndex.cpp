@@ -0,0 +1,390 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTargetingSpatialIndex.h"
+#include "Game/SPGame/Skill/Task/SPTargetingSpatialQuery.h"
+#include "Game/SPGame/Character/SPGameCharacterBase.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("SP Targeting Spatial Index Update"), STAT_SPTargetingSpatialIndexUpdate, STATGROUP_USPAbility);
+DECLARE_CYCLE_STAT(TEXT("SP Targeting Spatial Index Query"), STAT_SPTargetingSpatialIndexQuery, STATGROUP_USPAbility);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SP Targeting Spatial Index Actors"), STAT_SPTargetingSpatialIndexActors, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP Targeting Spatial Index Cell Moves"), STAT_SPTargetingSpatialIndexCellMoves, STATGROUP_USPAbility);
+
+static TAutoConsoleVariable<float> CVarSPTargetingSpatialIndexCellSize(
+	TEXT("SP.Targeting.SpatialIndex.CellSize"),
+	1000.0f,
+	TEXT("Size of a targeting spatial index cell, read when the world starts."));
+
+void USPTargetingSpatialIndex::RegisterActor(AActor* Actor)
+{
+	if (!IsValid(Actor) || m_ActorToEntry.Contains(FObjectKey(Actor)))
+	{
+		return;
+	}
+
+	FEntry Entry;
+	Entry.Actor = Actor;
+	Entry.ActorKey = FObjectKey(Actor);
+	Entry.Location = Actor->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+
+	const int32 EntryIndex = m_Entries.Add(MoveTemp(Entry));
+	m_ActorToEntry.Add(FObjectKey(Actor), EntryIndex);
+	AddToCell(EntryIndex);
+
+	// Only actors that moved are re-hashed on Tick.
+	if (USceneComponent* RootComponent = Actor->GetRootComponent())
+	{
+		FEntry& AddedEntry = m_Entries[EntryIndex];
+		AddedEntry.RootComponent = RootComponent;
+		AddedEntry.TransformUpdatedHandle = RootComponent->TransformUpdated.AddUObject(this, &USPTargetingSpatialIndex::OnRootComponentMoved, EntryIndex);
+	}
+}
+
+void USPTargetingSpatialIndex::UnregisterActor(AActor* Actor)
+{
+	if (const int32* EntryIndex = m_ActorToEntry.Find(FObjectKey(Actor)))
+	{
+		RemoveEntry(*EntryIndex);
+	}
+}
+
+void USPTargetingSpatialIndex::RemoveEntry(int32 EntryIndex)
+{
+	FEntry& Entry = m_Entries[EntryIndex];
+	if (USceneComponent* RootComponent = Entry.RootComponent.Get())
+	{
+		RootComponent->TransformUpdated.Remove(Entry.TransformUpdatedHandle);
+	}
+
+	m_ActorToEntry.Remove(Entry.ActorKey);
+	RemoveFromCell(EntryIndex);
+	m_Entries.RemoveAt(EntryIndex);
+}
+
+FIntPoint USPTargetingSpatialIndex::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / m_CellSize), FMath::FloorToInt(Location.Y / m_CellSize));
+}
+
+template <typename VisitorType>
+void USPTargetingSpatialIndex::ForEachEntryInBounds(const FBox2D& Bounds, VisitorType&& Visitor) const
+{
+	const FIntPoint MinCell = GetCell(FVector(Bounds.Min, 0.0f));
+	const FIntPoint MaxCell = GetCell(FVector(Bounds.Max, 0.0f));
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			if (const TArray<int32>* Cell = m_Cells.Find(FIntPoint(X, Y)))
+			{
+				for (const int32 EntryIndex : *Cell)
+				{
+					Visitor(m_Entries[EntryIndex]);
+				}
+			}
+		}
+	}
+}
+
+void USPTargetingSpatialIndex::QueryRadius(const FVector& Origin, float Radius, TArray<AActor*>& OutActors) const
+{
+	FSPTargetingSpatialShape Shape;
+	Shape.Shape = SPTargetingRadius;
+	Shape.Transform.SetLocation(Origin);
+	Shape.Radius = Radius;
+	QueryShape(Shape, OutActors);
+}
+
+void USPTargetingSpatialIndex::QueryCone(const FVector& Origin, const FVector& Direction, float Radius, float HalfAngle, TArray<AActor*>& OutActors) const
+{
+	FSPTargetingSpatialShape Shape;
+	Shape.Shape = SPTargetingCone;
+	Shape.Transform = FTransform(Direction.GetSafeNormal().ToOrientationQuat(), Origin);
+	Shape.Radius = Radius;
+	Shape.CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(HalfAngle, 0.0f, 180.0f)));
+	QueryShape(Shape, OutActors);
+}
+
+void USPTargetingSpatialIndex::QueryBox(const FTransform& Transform, const FVector& Extent, TArray<AActor*>& OutActors) const
+{
+	FSPTargetingSpatialShape Shape;
+	Shape.Shape = SPTargetingBox;
+	Shape.Transform = FTransform(Transform.GetRotation(), Transform.GetLocation());
+	Shape.BoxHalfExtents = Extent;
+	QueryShape(Shape, OutActors);
+}
+
+void USPTargetingSpatialIndex::QueryShape(const FSPTargetingSpatialShape& Shape, TArray<AActor*>& OutActors) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SPTargetingSpatialIndexQuery);
+
+	ForEachEntryInBounds(Shape.GetBounds(), [&](const FEntry& Entry)
+	{
+		if (Shape.Contains(Entry.Location))
+		{
+			if (AActor* Actor = Entry.Actor.Get())
+			{
+				OutActors.Add(Actor);
+			}
+		}
+	});
+}
+
+void USPTargetingSpatialIndex::GatherCandidates(const FVector& Origin, float Radius, TArray<FSPTargetingCandidate>& OutCandidates) const
+{
+	GatherCandidates(FBox2D(FVector2D(Origin) - FVector2D(Radius), FVector2D(Origin) + FVector2D(Radius)), OutCandidates);
+}
+
+void USPTargetingSpatialIndex::GatherCandidates(const FBox2D& Bounds, TArray<FSPTargetingCandidate>& OutCandidates) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SPTargetingSpatialIndexQuery);
+
+	if (!Bounds.bIsValid)
+	{
+		return;
+	}
+
+	ForEachEntryInBounds(Bounds, [&](const FEntry& Entry)
+	{
+		FSPTargetingCandidate& Candidate = OutCandidates.AddDefaulted_GetRef();
+		Candidate.Actor = Entry.Actor;
+		Candidate.Location = Entry.Location;
+	});
+}
+
+void USPTargetingSpatialIndex::AddToCell(int32 EntryIndex)
+{
+	m_Cells.FindOrAdd(m_Entries[EntryIndex].Cell).Add(EntryIndex);
+}
+
+void USPTargetingSpatialIndex::RemoveFromCell(int32 EntryIndex)
+{
+	const FIntPoint Cell = m_Entries[EntryIndex].Cell;
+	if (TArray<int32>* CellEntries = m_Cells.Find(Cell))
+	{
+		CellEntries->RemoveSingleSwap(EntryIndex);
+		if (CellEntries->Num() == 0)
+		{
+			m_Cells.Remove(Cell);
+		}
+	}
+}
+
+void USPTargetingSpatialIndex::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_CellSize = FMath::Max(1.0f, CVarSPTargetingSpatialIndexCellSize.GetValueOnGameThread());
+	m_ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &USPTargetingSpatialIndex::OnActorSpawned));
+	m_ActorDestroyedHandle = GetWorld()->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &USPTargetingSpatialIndex::OnActorDestroyed));
+	m_LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &USPTargetingSpatialIndex::OnLevelAddedToWorld);
+	m_LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &USPTargetingSpatialIndex::OnLevelRemovedFromWorld);
+}
+
+void USPTargetingSpatialIndex::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(m_ActorSpawnedHandle);
+		World->RemoveOnActorDestroyededHandler(m_ActorDestroyedHandle);
+	}
+
+	FWorldDelegates::LevelAddedToWorld.Remove(m_LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(m_LevelRemovedHandle);
+
+	for (auto It = m_Entries.CreateIterator(); It; ++It)
+	{
+		if (USceneComponent* RootComponent = It->RootComponent.Get())
+		{
+			RootComponent->TransformUpdated.Remove(It->TransformUpdatedHandle);
+		}
+	}
+
+	m_Entries.Empty();
+	m_DirtyEntries.Empty();
+	m_ActorToEntry.Empty();
+	m_Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+void USPTargetingSpatialIndex::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Actors placed in the level were never spawned.
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		OnActorSpawned(*It);
+	}
+}
+
+void USPTargetingSpatialIndex::OnActorSpawned(AActor* Actor)
+{
+	if (Cast<ISPActorInterface>(Actor))
+	{
+		RegisterActor(Actor);
+	}
+}
+
+void USPTargetingSpatialIndex::OnActorDestroyed(AActor* Actor)
+{
+	UnregisterActor(Actor);
+}
+
+void USPTargetingSpatialIndex::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	// Streamed in actors are neither spawned nor there when the world begins play.
+	if (Level && World == GetWorld())
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			OnActorSpawned(Actor);
+		}
+	}
+}
+
+void USPTargetingSpatialIndex::OnLevelRemovedFromWorld(ULevel* Level, UWorld* World)
+{
+	if (Level && World == GetWorld())
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			UnregisterActor(Actor);
+		}
+	}
+}
+
+void USPTargetingSpatialIndex::OnRootComponentMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport, int32 EntryIndex)
+{
+	if (m_Entries.IsValidIndex(EntryIndex) && !m_Entries[EntryIndex].bDirty)
+	{
+		m_Entries[EntryIndex].bDirty = true;
+		m_DirtyEntries.Add(EntryIndex);
+	}
+}
+
+void USPTargetingSpatialIndex::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SPTargetingSpatialIndexUpdate);
+	SET_DWORD_STAT(STAT_SPTargetingSpatialIndexActors, m_Entries.Num());
+
+	for (const int32 EntryIndex : m_DirtyEntries)
+	{
+		// The entry can be gone, or its index reused by an entry that is fine to refresh.
+		if (!m_Entries.IsValidIndex(EntryIndex))
+		{
+			continue;
+		}
+
+		FEntry& Entry = m_Entries[EntryIndex];
+		Entry.bDirty = false;
+		const AActor* Actor = Entry.Actor.Get();
+		if (!IsValid(Actor))
+		{
+			RemoveEntry(EntryIndex);
+			continue;
+		}
+
+		Entry.Location = Actor->GetActorLocation();
+		const FIntPoint Cell = GetCell(Entry.Location);
+		if (Cell != Entry.Cell)
+		{
+			INC_DWORD_STAT(STAT_SPTargetingSpatialIndexCellMoves);
+			RemoveFromCell(EntryIndex);
+			Entry.Cell = Cell;
+			AddToCell(EntryIndex);
+		}
+	}
+	m_DirtyEntries.Reset();
+}
+
+TStatId USPTargetingSpatialIndex::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USPTargetingSpatialIndex, STATGROUP_USPAbility);
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs SPTargetingBenchmarkSpatialIndexCommand(
+	TEXT("SP.Targeting.BenchmarkSpatialIndex"),
+	TEXT("SP.Targeting.BenchmarkSpatialIndex [NumActors=1000] [NumQueries=1000] [Radius=1500]. Compares radius queries on the targeting spatial index with physics overlaps, using temporary actors."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		USPTargetingSpatialIndex* SpatialIndex = World ? World->GetSubsystem<USPTargetingSpatialIndex>() : nullptr;
+		if (!SpatialIndex)
+		{
+			return;
+		}
+
+		const int32 NumActors = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const int32 NumQueries = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1000;
+		const float Radius = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 1500.0f;
+		const float HalfSize = FMath::Sqrt((float)NumActors) * 500.0f;
+
+		FRandomStream Random(NumActors);
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TArray<AActor*> Actors;
+		Actors.Reserve(NumActors);
+		for (int32 Index = 0; Index < NumActors; ++Index)
+		{
+			const FVector Location(Random.FRandRange(-HalfSize, HalfSize), Random.FRandRange(-HalfSize, HalfSize), 0.0f);
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Location), SpawnParameters);
+			USphereComponent* Sphere = NewObject<USphereComponent>(Actor);
+			Sphere->InitSphereRadius(50.0f);
+			Sphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+			Sphere->SetCollisionObjectType(ECC_Pawn);
+			Sphere->SetCollisionResponseToAllChannels(ECR_Overlap);
+			Actor->SetRootComponent(Sphere);
+			Sphere->RegisterComponent();
+			Actor->SetActorLocation(Location);
+			SpatialIndex->RegisterActor(Actor);
+			Actors.Add(Actor);
+		}
+
+		TArray<FVector> Origins;
+		for (int32 Index = 0; Index < NumQueries; ++Index)
+		{
+			Origins.Add(FVector(Random.FRandRange(-HalfSize, HalfSize), Random.FRandRange(-HalfSize, HalfSize), 0.0f));
+		}
+
+		int64 IndexFound = 0;
+		TArray<AActor*> Found;
+		const double IndexStart = FPlatformTime::Seconds();
+		for (const FVector& Origin : Origins)
+		{
+			Found.Reset();
+			SpatialIndex->QueryRadius(Origin, Radius, Found);
+			IndexFound += Found.Num();
+		}
+		const double IndexSeconds = FPlatformTime::Seconds() - IndexStart;
+
+		int64 PhysicsFound = 0;
+		TArray<FOverlapResult> Overlaps;
+		const FCollisionShape Sphere = FCollisionShape::MakeSphere(Radius);
+		const double PhysicsStart = FPlatformTime::Seconds();
+		for (const FVector& Origin : Origins)
+		{
+			Overlaps.Reset();
+			World->OverlapMultiByObjectType(Overlaps, Origin, FQuat::Identity, FCollisionObjectQueryParams(ECC_Pawn), Sphere);
+			PhysicsFound += Overlaps.Num();
+		}
+		const double PhysicsSeconds = FPlatformTime::Seconds() - PhysicsStart;
+
+		UE_LOG(LogTemp, Log, TEXT("SP Targeting, %d actors (%d indexed), %d radius %.0f queries: spatial index %.3f us/query (%lld found), physics overlap %.3f us/query (%lld found)."),
+			NumActors, SpatialIndex->GetNumActors(), NumQueries, Radius, IndexSeconds * 1.0e6 / NumQueries, IndexFound, PhysicsSeconds * 1.0e6 / NumQueries, PhysicsFound);
+
+		for (AActor* Actor : Actors)
+		{
+			SpatialIndex->UnregisterActor(Actor);
+			Actor->Destroy();
+		}
+	}));
+#endif
@@ -0,0 +1,134 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "SPTargetingSpatialIndex.generated.h"
+
+struct FSPTargetingSpatialShape;
+
+/* A targetable actor where the index last saw it. Plain data, so it can be read off the game thread. */
+struct FSPTargetingCandidate
+{
+	TWeakObjectPtr<AActor> Actor;
+
+	FVector Location = FVector::ZeroVector;
+};
+
+/**
+ * Spatial hash of every targetable (ISPActorInterface) actor in the world, for targeting without physics overlaps.
+ * Actors register themselves when spawned or when their level streams in, and the hash re-reads the actors that moved at the end of every frame.
+ * Queries test the locations from that update, so they can be up to a frame old.
+ */
+UCLASS()
+class FEATURE_SP_API USPTargetingSpatialIndex : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* Adds an actor that is not picked up automatically. */
+	void RegisterActor(AActor* Actor);
+
+	void UnregisterActor(AActor* Actor);
+
+	/* Appends every actor within Radius of Origin. */
+	void QueryRadius(const FVector& Origin, float Radius, TArray<AActor*>& OutActors) const;
+
+	/* Appends every actor within Radius of Origin and HalfAngle degrees of Direction. */
+	void QueryCone(const FVector& Origin, const FVector& Direction, float Radius, float HalfAngle, TArray<AActor*>& OutActors) const;
+
+	/* Appends every actor inside the box of the given half extent, placed by Transform (scale is ignored). */
+	void QueryBox(const FTransform& Transform, const FVector& Extent, TArray<AActor*>& OutActors) const;
+
+	/* Appends every actor inside the shape. */
+	void QueryShape(const FSPTargetingSpatialShape& Shape, TArray<AActor*>& OutActors) const;
+
+	/* Appends every actor in the cells overlapping the circle, without testing their exact distance. */
+	void GatherCandidates(const FVector& Origin, float Radius, TArray<FSPTargetingCandidate>& OutCandidates) const;
+
+	/* Appends every actor in the cells overlapping the bounds, on the XY plane. */
+	void GatherCandidates(const FBox2D& Bounds, TArray<FSPTargetingCandidate>& OutCandidates) const;
+
+	FORCEINLINE int32 GetNumActors() const { return m_Entries.Num(); }
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+protected:
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		FObjectKey ActorKey;
+
+		FVector Location = FVector::ZeroVector;
+
+		FIntPoint Cell = FIntPoint::ZeroValue;
+
+		/* The component whose TransformUpdated marks the entry dirty. */
+		TWeakObjectPtr<USceneComponent> RootComponent;
+
+		FDelegateHandle TransformUpdatedHandle;
+
+		/* Set while the entry waits in m_DirtyEntries. */
+		bool bDirty = false;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/* Calls Visitor with every entry in the cells overlapping the bounds, on the XY plane. */
+	template <typename VisitorType>
+	void ForEachEntryInBounds(const FBox2D& Bounds, VisitorType&& Visitor) const;
+
+	template <typename VisitorType>
+	void ForEachEntryInRange(const FVector& Origin, float Radius, VisitorType&& Visitor) const
+	{
+		ForEachEntryInBounds(FBox2D(FVector2D(Origin) - FVector2D(Radius), FVector2D(Origin) + FVector2D(Radius)), Forward<VisitorType>(Visitor));
+	}
+
+	void AddToCell(int32 EntryIndex);
+
+	void RemoveFromCell(int32 EntryIndex);
+
+	/* Unbinds the entry from its root component and removes it from the hash. */
+	void RemoveEntry(int32 EntryIndex);
+
+	void OnActorSpawned(AActor* Actor);
+
+	void OnActorDestroyed(AActor* Actor);
+
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+
+	void OnLevelRemovedFromWorld(ULevel* Level, UWorld* World);
+
+	void OnRootComponentMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport, int32 EntryIndex);
+
+	TSparseArray<FEntry> m_Entries;
+
+	/* Entries whose actor moved since the last Tick. May hold indices removed since. */
+	TArray<int32> m_DirtyEntries;
+
+	TMap<FObjectKey, int32> m_ActorToEntry;
+
+	TMap<FIntPoint, TArray<int32>> m_Cells;
+
+	float m_CellSize = 1000.0f;
+
+	FDelegateHandle m_ActorSpawnedHandle;
+
+	FDelegateHandle m_ActorDestroyedHandle;
+
+	FDelegateHandle m_LevelAddedHandle;
+
+	FDelegateHandle m_LevelRemovedHandle;
+};
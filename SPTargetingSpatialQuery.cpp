@@ -0,0 +1,146 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTargetingSpatialQuery.h"
+#include "Game/SPGame/Skill/Task/SPTargetingSpatialIndex.h"
+#include "ableAbilityContext.h"
+#include "Tasks/ablePlayAnimationTask.h"
+#include "Engine/World.h"
+
+float FSPTargetingSpatialShape::GetBoundingRadius() const
+{
+	return Shape == SPTargetingBox ? BoxHalfExtents.Size() : Radius;
+}
+
+FBox2D FSPTargetingSpatialShape::GetBounds() const
+{
+	const FVector2D Origin(GetOrigin());
+	const float BoundingRadius = GetBoundingRadius();
+	return FBox2D(Origin - FVector2D(BoundingRadius), Origin + FVector2D(BoundingRadius));
+}
+
+bool FSPTargetingSpatialShape::Contains(const FVector& Location) const
+{
+	switch (Shape)
+	{
+	case SPTargetingRadius:
+		return FVector::DistSquared(Location, GetOrigin()) <= FMath::Square(Radius);
+	case SPTargetingCone:
+	{
+		const FVector ToLocation = Location - GetOrigin();
+		const float DistanceSquared = ToLocation.SizeSquared();
+		if (DistanceSquared > FMath::Square(Radius))
+		{
+			return false;
+		}
+
+		// Anything on the apex is inside.
+		return DistanceSquared <= KINDA_SMALL_NUMBER || FVector::DotProduct(ToLocation * FMath::InvSqrt(DistanceSquared), Transform.GetUnitAxis(EAxis::X)) >= CosHalfAngle;
+	}
+	case SPTargetingBox:
+	{
+		const FVector Local = Transform.InverseTransformPositionNoScale(Location);
+		return FMath::Abs(Local.X) <= BoxHalfExtents.X && FMath::Abs(Local.Y) <= BoxHalfExtents.Y && FMath::Abs(Local.Z) <= BoxHalfExtents.Z;
+	}
+	default:
+		return false;
+	}
+}
+
+void FSPTargetingSpatialShape::Evaluate(const TArray<FSPTargetingCandidate>& Candidates, TArray<TWeakObjectPtr<AActor>>& OutTargets) const
+{
+	TArray<TPair<float, int32>, TInlineAllocator<32>> Inside;
+	for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+	{
+		if (Contains(Candidates[Index].Location))
+		{
+			Inside.Emplace(FVector::DistSquared(Candidates[Index].Location, GetOrigin()), Index);
+		}
+	}
+
+	Inside.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	OutTargets.Reserve(OutTargets.Num() + Inside.Num());
+	for (const TPair<float, int32>& Entry : Inside)
+	{
+		OutTargets.Add(Candidates[Entry.Value].Actor);
+	}
+}
+
+USPTargetingSpatialQuery::USPTargetingSpatialQuery(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer),
+	m_Shape(SPTargetingRadius),
+	m_Radius(500.0f),
+	m_ConeHalfAngle(45.0f),
+	m_BoxHalfExtents(250.0f, 250.0f, 250.0f)
+{
+}
+
+void USPTargetingSpatialQuery::FindTargets(UAbleAbilityContext& Context) const
+{
+	TArray<TWeakObjectPtr<AActor>> Targets;
+	QueryTargets(Context, MakeShape(Context), Targets);
+	CommitTargets(Context, Targets);
+}
+
+void USPTargetingSpatialQuery::QueryTargets(const UAbleAbilityContext& Context, const FSPTargetingSpatialShape& Shape, TArray<TWeakObjectPtr<AActor>>& OutTargets) const
+{
+	const UWorld* World = Context.GetWorld();
+	const USPTargetingSpatialIndex* SpatialIndex = World ? World->GetSubsystem<USPTargetingSpatialIndex>() : nullptr;
+	if (!SpatialIndex)
+	{
+		return;
+	}
+
+	TArray<FSPTargetingCandidate> Candidates;
+	SpatialIndex->GatherCandidates(Shape.GetOrigin(), Shape.GetBoundingRadius(), Candidates);
+	Shape.Evaluate(Candidates, OutTargets);
+}
+
+void USPTargetingSpatialQuery::InitShape(ESPTargetingSpatialShape Shape, float Radius, float ConeHalfAngle, const FVector& BoxHalfExtents)
+{
+	m_Shape = Shape;
+	m_Radius = Radius;
+	m_ConeHalfAngle = ConeHalfAngle;
+	m_BoxHalfExtents = BoxHalfExtents;
+}
+
+bool USPTargetingSpatialQuery::DependsOnTargets() const
+{
+	return m_Location.GetSourceTargetType() == EAbleAbilityTargetType::ATT_TargetActor;
+}
+
+FSPTargetingSpatialShape USPTargetingSpatialQuery::MakeShape(const UAbleAbilityContext& Context) const
+{
+	FSPTargetingSpatialShape Shape;
+	Shape.Shape = m_Shape.GetValue();
+	UAblePlayAnimationTask::EvaluateServerPoseForLocation(&Context, m_Location);
+	m_Location.GetTransform(Context, Shape.Transform);
+	Shape.Transform.SetScale3D(FVector::OneVector);
+	Shape.Radius = m_Radius;
+	Shape.CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(m_ConeHalfAngle, 0.0f, 180.0f)));
+	Shape.BoxHalfExtents = m_BoxHalfExtents;
+	return Shape;
+}
+
+void USPTargetingSpatialQuery::CommitTargets(UAbleAbilityContext& Context, const TArray<TWeakObjectPtr<AActor>>& Targets) const
+{
+	TArray<TWeakObjectPtr<AActor>>& TargetActors = Context.GetMutableTargetActors();
+	for (const TWeakObjectPtr<AActor>& Target : Targets)
+	{
+		// Actors can be destroyed between the query and the commit.
+		if (Target.IsValid())
+		{
+			TargetActors.AddUnique(Target);
+		}
+	}
+
+	// Run the rule's filters, same as the physics based rules.
+	FilterTargets(Context);
+}
+
+float USPTargetingSpatialQuery::CalculateRange() const
+{
+	const float Range = m_Shape == SPTargetingBox ? m_BoxHalfExtents.Size() : m_Radius;
+	return Range + m_Location.GetOffset().Size();
+}
@@ -0,0 +1,96 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Targeting/ableTargetingBase.h"
+#include "SPTargetingSpatialQuery.generated.h"
+
+UENUM(BlueprintType)
+enum ESPTargetingSpatialShape
+{
+	SPTargetingRadius UMETA(DisplayName = "Radius"),
+	SPTargetingCone UMETA(DisplayName = "Cone"),
+	SPTargetingBox UMETA(DisplayName = "Box")
+};
+
+struct FSPTargetingCandidate;
+
+/* The shape of a spatial query, resolved on the game thread so candidates can be tested on any thread. */
+struct FEATURE_SP_API FSPTargetingSpatialShape
+{
+	ESPTargetingSpatialShape Shape = SPTargetingRadius;
+
+	FTransform Transform = FTransform::Identity;
+
+	float Radius = 0.0f;
+
+	float CosHalfAngle = -1.0f;
+
+	FVector BoxHalfExtents = FVector::ZeroVector;
+
+	FORCEINLINE FVector GetOrigin() const { return Transform.GetLocation(); }
+
+	/* Radius of the circle around the origin that holds the whole shape. */
+	float GetBoundingRadius() const;
+
+	/* XY bounds of that circle, to gather candidates for several shapes at once. */
+	FBox2D GetBounds() const;
+
+	bool Contains(const FVector& Location) const;
+
+	/* Appends the candidates inside the shape, nearest to the origin first. */
+	void Evaluate(const TArray<FSPTargetingCandidate>& Candidates, TArray<TWeakObjectPtr<AActor>>& OutTargets) const;
+};
+
+/**
+ * Targets every SP actor inside a radius, cone or box, read from the world's targeting spatial index instead of a physics overlap.
+ * Tests actor locations rather than collision, so large actors are only found once their center is inside the shape.
+ * Targets are ordered nearest first.
+ */
+UCLASS(EditInlineNew, hidecategories = ("Collision"))
+class FEATURE_SP_API USPTargetingSpatialQuery : public UAbleTargetingBase
+{
+	GENERATED_BODY()
+
+public:
+	USPTargetingSpatialQuery(const FObjectInitializer& ObjectInitializer);
+
+	virtual void FindTargets(UAbleAbilityContext& Context) const override;
+
+	virtual float CalculateRange() const override;
+
+	/* Sets up the rule from code, for rules not authored in an ability. */
+	void InitShape(ESPTargetingSpatialShape Shape, float Radius, float ConeHalfAngle, const FVector& BoxHalfExtents);
+
+	/* Returns true if the query location follows the context's targets, so the shape can only be resolved once earlier rules have committed. */
+	bool DependsOnTargets() const;
+
+	/* Resolves the shape at the query location. Game thread only. */
+	FSPTargetingSpatialShape MakeShape(const UAbleAbilityContext& Context) const;
+
+	/* Appends the actors inside the shape, nearest first, before the rule's filters run. */
+	void QueryTargets(const UAbleAbilityContext& Context, const FSPTargetingSpatialShape& Shape, TArray<TWeakObjectPtr<AActor>>& OutTargets) const;
+
+	/* Adds targets found with this rule's shape to the context and runs the rule's filters. Game thread only. */
+	void CommitTargets(UAbleAbilityContext& Context, const TArray<TWeakObjectPtr<AActor>>& Targets) const;
+
+	FORCEINLINE ESPTargetingSpatialShape GetShape() const { return m_Shape.GetValue(); }
+
+	FORCEINLINE float GetRadius() const { return m_Radius; }
+
+protected:
+	UPROPERTY(EditAnywhere, Category = "Spatial Query", meta = (DisplayName = "Shape"))
+	TEnumAsByte<ESPTargetingSpatialShape> m_Shape;
+
+	/* Radius of the sphere and the cone. */
+	UPROPERTY(EditAnywhere, Category = "Spatial Query", meta = (DisplayName = "Radius", ClampMin = 0, EditCondition = "m_Shape != SPTargetingBox"))
+	float m_Radius;
+
+	/* Half angle of the cone around the query's forward, in degrees. */
+	UPROPERTY(EditAnywhere, Category = "Spatial Query", meta = (DisplayName = "Cone Half Angle", ClampMin = 0, ClampMax = 180, EditCondition = "m_Shape == SPTargetingCone"))
+	float m_ConeHalfAngle;
+
+	UPROPERTY(EditAnywhere, Category = "Spatial Query", meta = (DisplayName = "Box Half Extents", EditCondition = "m_Shape == SPTargetingBox"))
+	FVector m_BoxHalfExtents;
+};
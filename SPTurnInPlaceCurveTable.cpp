@@ -0,0 +1,96 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTurnInPlaceCurveTable.h"
+#include "Animation/AnimSequence.h"
+
+float FSPTurnInPlaceCurve::Evaluate(float Time) const
+{
+	if (YawSamples.Num() == 0 || Duration <= 0.0f || Time >= Duration)
+	{
+		return 1.0f;
+	}
+
+	const float SamplePosition = FMath::Max(0.0f, Time) / Duration * (YawSamples.Num() - 1);
+	const int32 Index = FMath::Min((int32)SamplePosition, YawSamples.Num() - 2);
+	if (Index < 0)
+	{
+		return YawSamples[0] / 65535.0f;
+	}
+
+	return FMath::Lerp(YawSamples[Index] / 65535.0f, YawSamples[Index + 1] / 65535.0f, SamplePosition - Index);
+}
+
+const FSPTurnInPlaceCurve* USPTurnInPlaceCurveTable::FindCurve(float DeltaYaw, float MaxDuration) const
+{
+	const FSPTurnInPlaceCurve* Best = nullptr;
+	float BestError = MaxAngleError;
+	for (const FSPTurnInPlaceCurve& Curve : Curves)
+	{
+		if (Curve.YawSamples.Num() == 0 || FMath::Sign(Curve.TurnAngle) != FMath::Sign(DeltaYaw) || Curve.Duration > MaxDuration)
+		{
+			continue;
+		}
+
+		const float Error = FMath::Abs(Curve.TurnAngle - DeltaYaw);
+		if (Error <= BestError)
+		{
+			Best = &Curve;
+			BestError = Error;
+		}
+	}
+
+	return Best;
+}
+
+#if WITH_EDITOR
+void USPTurnInPlaceCurveTable::ExtractCurves()
+{
+	Modify();
+
+	for (FSPTurnInPlaceCurve& Curve : Curves)
+	{
+		Curve.YawSamples.Reset();
+		Curve.TurnAngle = 0.0f;
+		Curve.Duration = 0.0f;
+
+		const UAnimSequence* Animation = Curve.Animation.LoadSynchronous();
+		if (!Animation)
+		{
+			continue;
+		}
+
+		Curve.Duration = Animation->GetPlayLength();
+		const int32 NumSamples = FMath::Max(2, FMath::CeilToInt(Curve.Duration * SampleRate) + 1);
+
+		// Unwind the yaw so turns over 180 degrees keep accumulating.
+		TArray<float> Yaws;
+		Yaws.Reserve(NumSamples);
+		float PreviousYaw = 0.0f;
+		float AccumulatedYaw = 0.0f;
+		for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+		{
+			const float Time = Curve.Duration * Sample / (NumSamples - 1);
+			const float Yaw = Animation->ExtractRootMotionFromRange(0.0f, Time).GetRotation().Rotator().Yaw;
+			AccumulatedYaw += FRotator::NormalizeAxis(Yaw - PreviousYaw);
+			PreviousYaw = Yaw;
+			Yaws.Add(AccumulatedYaw);
+		}
+
+		Curve.TurnAngle = AccumulatedYaw;
+		if (FMath::IsNearlyZero(Curve.TurnAngle))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("USPTurnInPlaceCurveTable::ExtractCurves %s has no root motion yaw."), *Animation->GetName());
+			continue;
+		}
+
+		Curve.YawSamples.Reserve(NumSamples);
+		for (const float Yaw : Yaws)
+		{
+			Curve.YawSamples.Add((uint16)FMath::RoundToInt(FMath::Clamp(Yaw / Curve.TurnAngle, 0.0f, 1.0f) * 65535.0f));
+		}
+	}
+
+	MarkPackageDirty();
+}
+#endif
@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SPTurnInPlaceCurveTable.generated.h"
+
+class UAnimSequence;
+
+/* The yaw of one turn in place animation over time, extracted from its root motion. */
+USTRUCT()
+struct FEATURE_SP_API FSPTurnInPlaceCurve
+{
+	GENERATED_BODY()
+
+#if WITH_EDITORONLY_DATA
+	/* The turn animation the curve is extracted from. */
+	UPROPERTY(EditAnywhere, Category = "Turn In Place")
+	TSoftObjectPtr<UAnimSequence> Animation;
+#endif
+
+	/* Total yaw of the animation, in degrees (negative turns left). */
+	UPROPERTY(VisibleAnywhere, Category = "Turn In Place")
+	float TurnAngle = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Turn In Place")
+	float Duration = 0.0f;
+
+	/* Fraction of TurnAngle reached at each sample, quantized to 16 bits. */
+	UPROPERTY()
+	TArray<uint16> YawSamples;
+
+	/* Returns the fraction of the turn done at the given time. */
+	float Evaluate(float Time) const;
+};
+
+/**
+ * Turn in place curves of a monster, so turns can follow the animation's yaw exactly without evaluating root motion at runtime.
+ * Extract Curves re-samples every animation in the editor.
+ */
+UCLASS(BlueprintType)
+class FEATURE_SP_API USPTurnInPlaceCurveTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/* Returns the curve whose angle is closest to the turn, turning the same way and no longer than MaxDuration (so the turn ends before its Task does).
+	*  Null if there is none within MaxAngleError, the turn then falls back to the Task blend. */
+	const FSPTurnInPlaceCurve* FindCurve(float DeltaYaw, float MaxDuration = TNumericLimits<float>::Max()) const;
+
+	/* Samples per second of every curve. */
+	UPROPERTY(EditAnywhere, Category = "Turn In Place", meta = (ClampMin = 1))
+	float SampleRate = 30.0f;
+
+	/* Largest difference in degrees between a turn and the curve it follows. */
+	UPROPERTY(EditAnywhere, Category = "Turn In Place", meta = (ClampMin = 0))
+	float MaxAngleError = 15.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Turn In Place")
+	TArray<FSPTurnInPlaceCurve> Curves;
+
+#if WITH_EDITOR
+	/* Samples the root motion yaw of every animation into its curve. */
+	UFUNCTION(CallInEditor, Category = "Turn In Place")
+	void ExtractCurves();
+#endif
+};
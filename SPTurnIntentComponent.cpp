@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTurnIntentComponent.h"
+#include "Game/SPGame/Skill/Task/SPTurnToSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+
+USPTurnIntentComponent::USPTurnIntentComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+USPTurnIntentComponent* USPTurnIntentComponent::FindOrAdd(AActor& Actor)
+{
+	if (USPTurnIntentComponent* Existing = Actor.FindComponentByClass<USPTurnIntentComponent>())
+	{
+		return Existing;
+	}
+
+	USPTurnIntentComponent* Component = NewObject<USPTurnIntentComponent>(&Actor);
+	Component->RegisterComponent();
+	return Component;
+}
+
+void USPTurnIntentComponent::BeginIntent(float StartYaw, float TargetYaw, const FAlphaBlend& Blend, bool bRotateOnSpot)
+{
+	AActor* Owner = GetOwner();
+	const UWorld* World = GetWorld();
+	if (!Owner || !World)
+	{
+		return;
+	}
+
+	const AGameStateBase* GameState = World->GetGameState();
+
+	m_Intent.StartYaw = FRotator::CompressAxisToShort(StartYaw);
+	m_Intent.TargetYaw = FRotator::CompressAxisToShort(TargetYaw);
+	m_Intent.BlendTime = Blend.GetBlendTime();
+	m_Intent.BlendOption = (uint8)Blend.GetBlendOption();
+	m_Intent.StartServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+	m_Intent.bRotateOnSpot = bRotateOnSpot;
+	m_Intent.bActive = true;
+	++m_Intent.Serial;
+
+	if (!m_bRestoreReplicateMovement)
+	{
+		m_bRestoreReplicateMovement = Owner->IsReplicatingMovement();
+	}
+	Owner->SetReplicateMovement(false);
+}
+
+void USPTurnIntentComponent::EndIntent()
+{
+	if (!m_Intent.bActive)
+	{
+		return;
+	}
+
+	m_Intent.bActive = false;
+	++m_Intent.Serial;
+
+	if (AActor* Owner = GetOwner())
+	{
+		if (m_bRestoreReplicateMovement)
+		{
+			// Sends the authoritative transform, which corrects whatever the clients simulated.
+			Owner->SetReplicateMovement(true);
+		}
+	}
+	m_bRestoreReplicateMovement = false;
+}
+
+void USPTurnIntentComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(USPTurnIntentComponent, m_Intent);
+}
+
+void USPTurnIntentComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (USPTurnToSubsystem* TurnToSubsystem = GetWorld() ? GetWorld()->GetSubsystem<USPTurnToSubsystem>() : nullptr)
+	{
+		TurnToSubsystem->RemoveTurns(*this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void USPTurnIntentComponent::OnRep_Intent()
+{
+	USPTurnToSubsystem* TurnToSubsystem = GetWorld() ? GetWorld()->GetSubsystem<USPTurnToSubsystem>() : nullptr;
+	if (!TurnToSubsystem)
+	{
+		return;
+	}
+
+	// A new intent replaces the one we were simulating.
+	TurnToSubsystem->RemoveTurns(*this);
+	if (m_Intent.bActive)
+	{
+		TurnToSubsystem->AddReplicatedTurn(*this);
+	}
+}
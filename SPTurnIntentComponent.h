@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AlphaBlend.h"
+#include "Components/ActorComponent.h"
+#include "SPTurnIntentComponent.generated.h"
+
+/* Everything a client needs to simulate a batched turn on its own, sent once per turn. */
+USTRUCT()
+struct FEATURE_SP_API FSPTurnIntent
+{
+	GENERATED_BODY()
+
+	/* Yaws are compressed with FRotator::CompressAxisToShort. */
+	UPROPERTY()
+	uint16 StartYaw = 0;
+
+	UPROPERTY()
+	uint16 TargetYaw = 0;
+
+	UPROPERTY()
+	float BlendTime = 0.0f;
+
+	/* EAlphaBlendOption of the turn blend. */
+	UPROPERTY()
+	uint8 BlendOption = 0;
+
+	/* Server world time the turn started at, so late clients catch up. */
+	UPROPERTY()
+	float StartServerTime = 0.0f;
+
+	UPROPERTY()
+	bool bRotateOnSpot = false;
+
+	UPROPERTY()
+	bool bActive = false;
+
+	/* Bumped for every new intent, so back to back turns always replicate. */
+	UPROPERTY()
+	uint8 Serial = 0;
+};
+
+/**
+ * Replicates the intent of a batched turn instead of the actor rotation.
+ * The server turns movement replication off while the turn runs and back on (which sends the corrected transform) once it ends or diverges.
+ * Added to actors on demand by USPTurnToSubsystem.
+ */
+UCLASS(ClassGroup = (SP))
+class FEATURE_SP_API USPTurnIntentComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USPTurnIntentComponent(const FObjectInitializer& ObjectInitializer);
+
+	/* Returns the intent component of the actor, adding it if needed. Server only. */
+	static USPTurnIntentComponent* FindOrAdd(AActor& Actor);
+
+	/* Starts replicating the turn and stops replicating movement. Server only. */
+	void BeginIntent(float StartYaw, float TargetYaw, const FAlphaBlend& Blend, bool bRotateOnSpot);
+
+	/* Stops the turn on clients and replicates movement again. Server only. */
+	void EndIntent();
+
+	FORCEINLINE bool HasActiveIntent() const { return m_Intent.bActive; }
+
+	FORCEINLINE const FSPTurnIntent& GetIntent() const { return m_Intent; }
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+protected:
+	UFUNCTION()
+	void OnRep_Intent();
+
+	UPROPERTY(ReplicatedUsing = OnRep_Intent)
+	FSPTurnIntent m_Intent;
+
+	/* Whether the actor replicated movement before the intent began. */
+	bool m_bRestoreReplicateMovement = false;
+};
@@ -0,0 +1,626 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTurnToSubsystem.h"
+#include "Game/SPGame/Skill/Task/SPTurnToTask.h"
+#include "Game/SPGame/Skill/Task/SPTurnIntentComponent.h"
+#include "Game/SPGame/Skill/Task/SPTurnInPlaceCurveTable.h"
+#include "Game/SPGame/Character/SPGameCharacterBase.h"
+#include "Game/SPGame/Character/SPGameMonsterBase.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSPTurnTo, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("SP Turn To Batch Solve"), STAT_SPTurnToBatchSolve, STATGROUP_USPAbility);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SP Turn To Batched Turns"), STAT_SPTurnToBatchedTurns, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP Turn To Rotate On Spot Writes"), STAT_SPTurnToRotateOnSpotWrites, STATGROUP_USPAbility);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SP Turn To Deferred Turns"), STAT_SPTurnToDeferredTurns, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP Turn To Intents Sent"), STAT_SPTurnToIntentsSent, STATGROUP_USPAbility);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("SP Turn To Intent Corrections"), STAT_SPTurnToIntentCorrections, STATGROUP_USPAbility);
+
+static TAutoConsoleVariable<float> CVarSPTurnToUpdateRate(
+	TEXT("SP.TurnTo.UpdateRate"),
+	0.0f,
+	TEXT("How many times per second batched turns are updated. 0 updates them every frame."));
+
+static TAutoConsoleVariable<FString> CVarSPTurnToLODDistances(
+	TEXT("SP.TurnTo.LOD.Distances"),
+	TEXT(""),
+	TEXT("Comma separated, ascending distances to the nearest player splitting batched turns into significance buckets. Empty updates every turn at full rate."));
+
+static TAutoConsoleVariable<FString> CVarSPTurnToLODIntervals(
+	TEXT("SP.TurnTo.LOD.Intervals"),
+	TEXT("0.1,0.25"),
+	TEXT("Comma separated seconds between updates for each bucket beyond the first. Turns inside a player's view (camera FOV) or rendered recently always update at full rate."));
+
+/* Bumped whenever one of the bucket settings above changes, so subsystems only parse them again then. */
+static int32 GSPTurnToLODSettingsVersion = 1;
+
+static const bool GSPTurnToLODCallbacksRegistered = []()
+{
+	const FConsoleVariableDelegate OnChanged = FConsoleVariableDelegate::CreateLambda([](IConsoleVariable*) { ++GSPTurnToLODSettingsVersion; });
+	CVarSPTurnToLODDistances->SetOnChangedCallback(OnChanged);
+	CVarSPTurnToLODIntervals->SetOnChangedCallback(OnChanged);
+	return true;
+}();
+
+static TAutoConsoleVariable<float> CVarSPTurnToLODReevaluateInterval(
+	TEXT("SP.TurnTo.LOD.ReevaluateInterval"),
+	0.5f,
+	TEXT("Seconds between significance evaluations of a batched turn."));
+
+static TAutoConsoleVariable<float> CVarSPTurnToIntentLocationTolerance(
+	TEXT("SP.TurnTo.Intent.LocationTolerance"),
+	10.0f,
+	TEXT("A replicated turn intent ends (and movement replication corrects the clients) once the actor moved further than this from where the turn began."));
+
+static TAutoConsoleVariable<float> CVarSPTurnToIntentYawTolerance(
+	TEXT("SP.TurnTo.Intent.YawTolerance"),
+	5.0f,
+	TEXT("A replicated turn intent ends once something other than the turn rotated the actor by more than this many degrees."));
+
+static TAutoConsoleVariable<float> CVarSPTurnToRotateOnSpotTolerance(
+	TEXT("SP.TurnTo.RotateOnSpotTolerance"),
+	1.0f,
+	TEXT("Batched turns only send a new rotate on spot direction to the monster once it moved by more than this many degrees."));
+
+void FSPTurnToBatchSolver::Reset(int32 ExpectedNum)
+{
+	CurrentYaw.Reset(ExpectedNum);
+	StartYaw.Reset(ExpectedNum);
+	TargetYaw.Reset(ExpectedNum);
+	Alpha.Reset(ExpectedNum);
+	OutYaw.Reset(ExpectedNum);
+	OutDeltaYaw.Reset(ExpectedNum);
+}
+
+int32 FSPTurnToBatchSolver::Add(float InCurrentYaw, float InStartYaw, float InTargetYaw, float InAlpha)
+{
+	CurrentYaw.Add(InCurrentYaw);
+	StartYaw.Add(InStartYaw);
+	TargetYaw.Add(InTargetYaw);
+	return Alpha.Add(InAlpha);
+}
+
+void FSPTurnToBatchSolver::Solve()
+{
+	const int32 Count = Num();
+	OutYaw.SetNumUninitialized(Count);
+	OutDeltaYaw.SetNumUninitialized(Count);
+
+	int32 Index = 0;
+	for (; Index + 4 <= Count; Index += 4)
+	{
+		const VectorRegister4Float Current = VectorLoad(CurrentYaw.GetData() + Index);
+		const VectorRegister4Float Start = VectorLoad(StartYaw.GetData() + Index);
+		const VectorRegister4Float Target = VectorLoad(TargetYaw.GetData() + Index);
+		const VectorRegister4Float Blend = VectorLoad(Alpha.GetData() + Index);
+
+		const VectorRegister4Float Arc = VectorNormalizeRotator(VectorSubtract(Target, Start));
+		const VectorRegister4Float Yaw = VectorMultiplyAdd(Arc, Blend, Start);
+
+		VectorStore(Yaw, OutYaw.GetData() + Index);
+		VectorStore(VectorNormalizeRotator(VectorSubtract(Yaw, Current)), OutDeltaYaw.GetData() + Index);
+	}
+
+	for (; Index < Count; ++Index)
+	{
+		const float Arc = FRotator::NormalizeAxis(TargetYaw[Index] - StartYaw[Index]);
+		OutYaw[Index] = StartYaw[Index] + Arc * Alpha[Index];
+		OutDeltaYaw[Index] = FRotator::NormalizeAxis(OutYaw[Index] - CurrentYaw[Index]);
+	}
+}
+
+void USPTurnToSubsystem::AddTurns(USPTurnToTaskScratchPad& ScratchPad, bool bReplicateIntent, const USPTurnInPlaceCurveTable* CurveTable, float TaskTimeRemaining)
+{
+	const FObjectKey Owner(&ScratchPad);
+	ScratchPad.bTurnsBatched = true;
+	const bool bServer = GetWorld()->GetNetMode() != NM_Client;
+	for (const FSPTurnToActorHandles& Handles : ScratchPad.ActorHandles)
+	{
+		AActor* Actor = Handles.Actor.Get();
+		if (!Actor)
+		{
+			continue;
+		}
+
+		// The local Task wins over a turn we were simulating from a replicated intent.
+		m_Turns.RemoveAllSwap([Actor](FActiveTurn& Other)
+		{
+			if (!Other.bReplicated || Other.Actor.Get() != Actor)
+			{
+				return false;
+			}
+
+			ReleaseTurn(Other);
+			return true;
+		});
+
+		FActiveTurn& Turn = m_Turns.AddDefaulted_GetRef();
+		Turn.Owner = Owner;
+		Turn.ScratchPad = &ScratchPad;
+		++ScratchPad.NumUnfinishedTurns;
+		Turn.Actor = Actor;
+		Turn.SPActor = Cast<ISPActorInterface>(Actor);
+		Turn.MonsterPawn = Handles.MonsterPawn;
+		Turn.Blend = ScratchPad.TurningBlend;
+		Turn.StartYaw = Handles.StartYaw;
+		Turn.TargetYaw = Handles.TargetYaw;
+		Turn.LastWrittenYaw = Actor->GetActorRotation().Yaw;
+
+		if (CurveTable)
+		{
+			if (const FSPTurnInPlaceCurve* Curve = CurveTable->FindCurve(FRotator::NormalizeAxis(Turn.TargetYaw - Turn.StartYaw), TaskTimeRemaining))
+			{
+				Turn.CurveTable = CurveTable;
+				Turn.CurveIndex = UE_PTRDIFF_TO_INT32(Curve - CurveTable->Curves.GetData());
+			}
+		}
+
+		// Clients simulate intents with the blend, so curve driven turns keep replicating their rotation.
+		if (bReplicateIntent && Turn.CurveIndex == INDEX_NONE && bServer && Actor->GetIsReplicated() && Actor->IsReplicatingMovement())
+		{
+			if (USPTurnIntentComponent* IntentComponent = USPTurnIntentComponent::FindOrAdd(*Actor))
+			{
+				IntentComponent->BeginIntent(Turn.StartYaw, Turn.TargetYaw, Turn.Blend, Turn.MonsterPawn.IsValid());
+				Turn.IntentComponent = IntentComponent;
+				Turn.IntentLocation = Actor->GetActorLocation();
+				INC_DWORD_STAT(STAT_SPTurnToIntentsSent);
+			}
+		}
+	}
+}
+
+void USPTurnToSubsystem::AddReplicatedTurn(const USPTurnIntentComponent& IntentComponent)
+{
+	AActor* Actor = IntentComponent.GetOwner();
+	if (!Actor)
+	{
+		return;
+	}
+
+	// A Task predicting the turn locally already drives the actor.
+	const bool bLocallyTurned = m_Turns.ContainsByPredicate([Actor](const FActiveTurn& Other)
+	{
+		return !Other.bReplicated && !Other.bFinished && Other.Actor.Get() == Actor;
+	});
+	if (bLocallyTurned)
+	{
+		return;
+	}
+
+	const FSPTurnIntent& Intent = IntentComponent.GetIntent();
+
+	FActiveTurn& Turn = m_Turns.AddDefaulted_GetRef();
+	Turn.Owner = FObjectKey(&IntentComponent);
+	Turn.Actor = Actor;
+	Turn.SPActor = Cast<ISPActorInterface>(Actor);
+	Turn.MonsterPawn = Intent.bRotateOnSpot ? Cast<ASPGameMonsterBase>(Actor) : nullptr;
+	Turn.StartYaw = FRotator::DecompressAxisFromShort(Intent.StartYaw);
+	Turn.TargetYaw = FRotator::DecompressAxisFromShort(Intent.TargetYaw);
+	Turn.LastWrittenYaw = Actor->GetActorRotation().Yaw;
+	Turn.bReplicated = true;
+
+	Turn.Blend = FAlphaBlend(Intent.BlendTime);
+	Turn.Blend.SetBlendOption((EAlphaBlendOption)Intent.BlendOption);
+
+	// Catch up on the time the intent spent in flight.
+	if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		Turn.PendingTime = FMath::Max(0.0f, GameState->GetServerWorldTimeSeconds() - Intent.StartServerTime);
+	}
+}
+
+void USPTurnToSubsystem::ReleaseTurn(FActiveTurn& Turn)
+{
+	if (USPTurnIntentComponent* IntentComponent = Turn.IntentComponent.Get())
+	{
+		IntentComponent->EndIntent();
+	}
+
+	// Tasks reset rotate on spot themselves, replicated turns have no Task.
+	if (Turn.bReplicated && Turn.bRotateOnSpot)
+	{
+		if (ASPGameMonsterBase* MonsterPawn = Turn.MonsterPawn.Get())
+		{
+			MonsterPawn->SetEnableRotateOnSpot(false);
+			MonsterPawn->SetRotateOnSpotDirection(0);
+		}
+	}
+}
+
+void USPTurnToSubsystem::RemoveTurns(const UObject& Owner)
+{
+	const FObjectKey OwnerKey(&Owner);
+	for (FActiveTurn& Turn : m_Turns)
+	{
+		if (Turn.Owner == OwnerKey)
+		{
+			ReleaseTurn(Turn);
+		}
+	}
+
+	m_Turns.RemoveAllSwap([&OwnerKey](const FActiveTurn& Turn) { return Turn.Owner == OwnerKey; });
+}
+
+void USPTurnToSubsystem::Tick(float DeltaTime)
+{
+	if (m_Turns.Num() == 0)
+	{
+		m_TimeSinceStep = 0.0f;
+		return;
+	}
+
+	m_TimeSinceStep += DeltaTime;
+
+	const float UpdateRate = CVarSPTurnToUpdateRate.GetValueOnGameThread();
+	if (UpdateRate > 0.0f && m_TimeSinceStep < 1.0f / UpdateRate)
+	{
+		return;
+	}
+
+	StepTurns(m_TimeSinceStep);
+	m_TimeSinceStep = 0.0f;
+}
+
+void USPTurnToSubsystem::StepTurns(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SPTurnToBatchSolve);
+
+	RefreshSignificanceBuckets();
+
+	m_PlayerViews.Reset();
+	if (m_BucketDistancesSquared.Num() > 0)
+	{
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			const APlayerController* PlayerController = It->Get();
+			if (!PlayerController || !PlayerController->GetPawn())
+			{
+				continue;
+			}
+
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			FPlayerView& View = m_PlayerViews.AddDefaulted_GetRef();
+			View.Location = ViewLocation;
+			View.Direction = ViewRotation.Vector();
+			const float FOV = PlayerController->PlayerCameraManager ? PlayerController->PlayerCameraManager->GetFOVAngle() : 90.0f;
+			View.CosHalfFOV = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(FOV, 1.0f, 179.0f) * 0.5f));
+		}
+	}
+
+	const float ReevaluateInterval = CVarSPTurnToLODReevaluateInterval.GetValueOnGameThread();
+
+	m_Solver.Reset(m_Turns.Num());
+	m_SolvedTurns.Reset(m_Turns.Num());
+	for (int32 Index = 0; Index < m_Turns.Num(); ++Index)
+	{
+		FActiveTurn& Turn = m_Turns[Index];
+		if (Turn.bFinished)
+		{
+			continue;
+		}
+
+		const AActor* Actor = Turn.Actor.Get();
+		if (!Actor || IsTurnComplete(Turn))
+		{
+			FinishTurn(Turn);
+			continue;
+		}
+
+		if (Turn.IntentComponent.IsValid())
+		{
+			CheckIntentDivergence(Turn, *Actor);
+		}
+
+		Turn.PendingTime += DeltaTime;
+		Turn.SignificanceCooldown -= DeltaTime;
+		if (Turn.SignificanceCooldown <= 0.0f)
+		{
+			Turn.UpdateInterval = GetSignificanceInterval(*Actor);
+			Turn.SignificanceCooldown = ReevaluateInterval;
+		}
+
+		// The yaw only depends on the elapsed time, so a deferred turn catches up exactly. Never defer past its end, so turns still finish on time.
+		if (Turn.PendingTime < Turn.UpdateInterval && Turn.PendingTime < GetTurnTimeRemaining(Turn))
+		{
+			INC_DWORD_STAT(STAT_SPTurnToDeferredTurns);
+			continue;
+		}
+
+		const float Alpha = AdvanceTurn(Turn, Turn.PendingTime);
+		Turn.PendingTime = 0.0f;
+		m_Solver.Add(Actor->GetActorRotation().Yaw, Turn.StartYaw, Turn.TargetYaw, Alpha);
+		m_SolvedTurns.Add(Index);
+	}
+
+	INC_DWORD_STAT_BY(STAT_SPTurnToBatchedTurns, m_SolvedTurns.Num());
+	m_Solver.Solve();
+
+	for (int32 SolvedIndex = 0; SolvedIndex < m_SolvedTurns.Num(); ++SolvedIndex)
+	{
+		FActiveTurn& Turn = m_Turns[m_SolvedTurns[SolvedIndex]];
+		AActor* Actor = Turn.Actor.Get();
+
+		FRotator Rotation = Actor->GetActorRotation();
+		Rotation.Yaw = m_Solver.OutYaw[SolvedIndex];
+		if (Turn.SPActor)
+		{
+			FHitResult Result = FHitResult();
+			Turn.SPActor->SPSetActorRotation(Rotation, false, Result);
+		}
+		else
+		{
+			Actor->SetActorRotation(Rotation);
+		}
+
+		Turn.LastWrittenYaw = Rotation.Yaw;
+
+		UpdateRotateOnSpot(Turn, m_Solver.OutDeltaYaw[SolvedIndex]);
+
+		// Tell the Task right away, so it can end this frame like an unbatched turn would.
+		if (IsTurnComplete(Turn))
+		{
+			FinishTurn(Turn);
+		}
+	}
+}
+
+float USPTurnToSubsystem::GetSignificanceInterval(const AActor& Actor) const
+{
+	if (m_BucketDistancesSquared.Num() == 0 || m_PlayerViews.Num() == 0 || Actor.WasRecentlyRendered())
+	{
+		return 0.0f;
+	}
+
+	const FVector Location = Actor.GetActorLocation();
+	float NearestDistanceSquared = TNumericLimits<float>::Max();
+	for (const FPlayerView& View : m_PlayerViews)
+	{
+		const FVector ToActor = Location - View.Location;
+		if (FVector::DotProduct(ToActor.GetSafeNormal(), View.Direction) >= View.CosHalfFOV)
+		{
+			// In front of a player, turn it smoothly regardless of the distance.
+			return 0.0f;
+		}
+
+		NearestDistanceSquared = FMath::Min(NearestDistanceSquared, (float)ToActor.SizeSquared());
+	}
+
+	int32 Bucket = 0;
+	while (Bucket < m_BucketDistancesSquared.Num() && NearestDistanceSquared > m_BucketDistancesSquared[Bucket])
+	{
+		++Bucket;
+	}
+
+	return Bucket == 0 || m_BucketIntervals.Num() == 0 ? 0.0f : m_BucketIntervals[FMath::Min(Bucket, m_BucketIntervals.Num()) - 1];
+}
+
+void USPTurnToSubsystem::RefreshSignificanceBuckets()
+{
+	if (m_BucketSettingsVersion == GSPTurnToLODSettingsVersion)
+	{
+		return;
+	}
+
+	m_BucketSettingsVersion = GSPTurnToLODSettingsVersion;
+	const FString DistancesSetting = CVarSPTurnToLODDistances.GetValueOnGameThread();
+	const FString IntervalsSetting = CVarSPTurnToLODIntervals.GetValueOnGameThread();
+
+	TArray<FString> Values;
+	m_BucketDistancesSquared.Reset();
+	DistancesSetting.ParseIntoArray(Values, TEXT(","));
+	for (const FString& Value : Values)
+	{
+		m_BucketDistancesSquared.Add(FMath::Square(FCString::Atof(*Value)));
+	}
+
+	m_BucketIntervals.Reset();
+	IntervalsSetting.ParseIntoArray(Values, TEXT(","));
+	for (const FString& Value : Values)
+	{
+		m_BucketIntervals.Add(FMath::Max(0.0f, FCString::Atof(*Value)));
+	}
+
+	// Turns pick up the new buckets on their next evaluation.
+	for (FActiveTurn& Turn : m_Turns)
+	{
+		Turn.SignificanceCooldown = 0.0f;
+	}
+}
+
+const FSPTurnInPlaceCurve* USPTurnToSubsystem::GetCurve(const FActiveTurn& Turn)
+{
+	const USPTurnInPlaceCurveTable* CurveTable = Turn.CurveTable.Get();
+	return CurveTable && CurveTable->Curves.IsValidIndex(Turn.CurveIndex) ? &CurveTable->Curves[Turn.CurveIndex] : nullptr;
+}
+
+bool USPTurnToSubsystem::IsTurnComplete(const FActiveTurn& Turn)
+{
+	if (const FSPTurnInPlaceCurve* Curve = GetCurve(Turn))
+	{
+		return Turn.CurveTime >= Curve->Duration;
+	}
+
+	return Turn.Blend.IsComplete();
+}
+
+void USPTurnToSubsystem::FinishTurn(FActiveTurn& Turn)
+{
+	Turn.bFinished = true;
+	if (USPTurnToTaskScratchPad* ScratchPad = Turn.ScratchPad.Get())
+	{
+		--ScratchPad->NumUnfinishedTurns;
+	}
+}
+
+float USPTurnToSubsystem::GetTurnTimeRemaining(const FActiveTurn& Turn)
+{
+	if (const FSPTurnInPlaceCurve* Curve = GetCurve(Turn))
+	{
+		return Curve->Duration - Turn.CurveTime;
+	}
+
+	return Turn.Blend.GetBlendTimeRemaining();
+}
+
+float USPTurnToSubsystem::AdvanceTurn(FActiveTurn& Turn, float DeltaTime)
+{
+	if (const FSPTurnInPlaceCurve* Curve = GetCurve(Turn))
+	{
+		// Played at the animation's own rate, so the feet stay where the animation puts them.
+		Turn.CurveTime += DeltaTime;
+		return Curve->Evaluate(Turn.CurveTime);
+	}
+
+	Turn.Blend.Update(DeltaTime);
+	return Turn.Blend.GetBlendedValue();
+}
+
+void USPTurnToSubsystem::CheckIntentDivergence(FActiveTurn& Turn, const AActor& Actor)
+{
+	const float LocationTolerance = CVarSPTurnToIntentLocationTolerance.GetValueOnGameThread();
+	const bool bMoved = FVector::DistSquared(Actor.GetActorLocation(), Turn.IntentLocation) > FMath::Square(LocationTolerance);
+	const bool bTurnedElsewhere = FMath::Abs(FRotator::NormalizeAxis(Actor.GetActorRotation().Yaw - Turn.LastWrittenYaw)) > CVarSPTurnToIntentYawTolerance.GetValueOnGameThread();
+	if (bMoved || bTurnedElsewhere)
+	{
+		INC_DWORD_STAT(STAT_SPTurnToIntentCorrections);
+		Turn.IntentComponent->EndIntent();
+		Turn.IntentComponent.Reset();
+	}
+}
+
+void USPTurnToSubsystem::UpdateRotateOnSpot(FActiveTurn& Turn, float DeltaYaw)
+{
+	ASPGameMonsterBase* MonsterPawn = Turn.MonsterPawn.Get();
+	if (!MonsterPawn)
+	{
+		return;
+	}
+
+	if (!Turn.bRotateOnSpot)
+	{
+		MonsterPawn->SetEnableRotateOnSpot(true);
+		Turn.bRotateOnSpot = true;
+		INC_DWORD_STAT(STAT_SPTurnToRotateOnSpotWrites);
+	}
+
+	if (FMath::Abs(DeltaYaw - Turn.RotateOnSpotDirection) > CVarSPTurnToRotateOnSpotTolerance.GetValueOnGameThread())
+	{
+		MonsterPawn->SetRotateOnSpotDirection(DeltaYaw);
+		Turn.RotateOnSpotDirection = DeltaYaw;
+		INC_DWORD_STAT(STAT_SPTurnToRotateOnSpotWrites);
+	}
+}
+
+void USPTurnToSubsystem::Deinitialize()
+{
+	m_Turns.Empty();
+	m_SolvedTurns.Empty();
+	m_Solver.Reset();
+
+	Super::Deinitialize();
+}
+
+TStatId USPTurnToSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USPTurnToSubsystem, STATGROUP_USPAbility);
+}
+
+#if !UE_BUILD_SHIPPING
+void USPTurnToSubsystem::RunBenchmark(UWorld* World, const TArray<FString>& Args)
+{
+	if (!World)
+	{
+		return;
+	}
+
+	const int32 NumTurns = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 256;
+	const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+	const float DeltaTime = 1.0f / 30.0f;
+	// Long enough that no turn finishes during the run.
+	const float BlendTime = (Iterations + 1) * DeltaTime * 2.0f;
+
+	FRandomStream Random(NumTurns);
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	USPTurnToTask* Task = NewObject<USPTurnToTask>(GetTransientPackage());
+	USPTurnToTaskScratchPad* ScratchPad = NewObject<USPTurnToTaskScratchPad>(GetTransientPackage());
+	ScratchPad->TurningBlend = FAlphaBlend(BlendTime);
+
+	TArray<AActor*> Actors;
+	for (int32 Index = 0; Index < NumTurns; ++Index)
+	{
+		const FVector Location(Random.FRandRange(-10000.0f, 10000.0f), Random.FRandRange(-10000.0f, 10000.0f), 0.0f);
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FRotator(0.0f, Random.FRandRange(-180.0f, 180.0f), 0.0f), Location), SpawnParameters);
+		USceneComponent* Root = NewObject<USceneComponent>(Actor);
+		Actor->SetRootComponent(Root);
+		Root->RegisterComponent();
+		Actors.Add(Actor);
+
+		FSPTurnToActorHandles& Handles = ScratchPad->ActorHandles.AddDefaulted_GetRef();
+		Handles.Actor = Actor;
+		Handles.StartYaw = Actor->GetActorRotation().Yaw;
+		Handles.TargetYaw = Random.FRandRange(-180.0f, 180.0f);
+	}
+
+	// The per-task path, what UAbleTurnToTask::OnTaskTick does for every Task instance: one blend, then each actor through the Task's virtuals.
+	FAlphaBlend PerTaskBlend(BlendTime);
+	const double PerTaskStart = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		PerTaskBlend.Update(DeltaTime);
+		const float Alpha = PerTaskBlend.GetBlendedValue();
+		for (const FSPTurnToActorHandles& Handles : ScratchPad->ActorHandles)
+		{
+			AActor* Actor = Handles.Actor.Get();
+			const FRotator Current = Actor->GetActorRotation();
+			const FRotator Rotation = FMath::Lerp(FRotator(Current.Pitch, Handles.StartYaw, Current.Roll), FRotator(Current.Pitch, Handles.TargetYaw, Current.Roll), Alpha);
+			Task->TurnToSetActorRotation(Actor, Rotation);
+			Task->TurnAnimation(Actor, FRotator::NormalizeAxis(Rotation.Yaw - Current.Yaw));
+		}
+	}
+	const double PerTaskSeconds = FPlatformTime::Seconds() - PerTaskStart;
+
+	for (const FSPTurnToActorHandles& Handles : ScratchPad->ActorHandles)
+	{
+		Handles.Actor->SetActorRotation(FRotator(0.0f, Handles.StartYaw, 0.0f));
+	}
+
+	// The batched path, on a subsystem of our own so the world's turns are left alone.
+	USPTurnToSubsystem* Subsystem = NewObject<USPTurnToSubsystem>(World);
+	Subsystem->AddTurns(*ScratchPad, false);
+	const double BatchedStart = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		Subsystem->StepTurns(DeltaTime);
+	}
+	const double BatchedSeconds = FPlatformTime::Seconds() - BatchedStart;
+	Subsystem->RemoveTurns(*ScratchPad);
+
+	for (AActor* Actor : Actors)
+	{
+		Actor->Destroy();
+	}
+
+	UE_LOG(LogSPTurnTo, Log, TEXT("SP Turn To, %d turns x %d ticks: batched %.3f us, per task %.3f us (per tick)."),
+		NumTurns, Iterations, BatchedSeconds * 1.0e6 / Iterations, PerTaskSeconds * 1.0e6 / Iterations);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SPTurnToBenchmarkCommand(
+	TEXT("SP.TurnTo.Benchmark"),
+	TEXT("SP.TurnTo.Benchmark [NumTurns=256] [Ticks=100]. Turns spawned actors through the batched subsystem and through the per-task Turn To path, and compares the time per tick."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		USPTurnToSubsystem::RunBenchmark(World, Args);
+	}));
+#endif
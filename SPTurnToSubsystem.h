@@ -0,0 +1,206 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AlphaBlend.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "SPTurnToSubsystem.generated.h"
+
+class ASPGameMonsterBase;
+class ISPActorInterface;
+class USPTurnInPlaceCurveTable;
+class USPTurnIntentComponent;
+class USPTurnToTaskScratchPad;
+struct FSPTurnInPlaceCurve;
+
+/**
+ * Struct of arrays yaw integrator for many turns at once.
+ * Every turn moves from its start yaw towards its target yaw along the shortest arc, by its blend alpha.
+ */
+struct FEATURE_SP_API FSPTurnToBatchSolver
+{
+	void Reset(int32 ExpectedNum = 0);
+
+	/* Adds a turn and returns its index in the output arrays. */
+	int32 Add(float InCurrentYaw, float InStartYaw, float InTargetYaw, float InAlpha);
+
+	/* Solves every turn, four at a time. */
+	void Solve();
+
+	FORCEINLINE int32 Num() const { return CurrentYaw.Num(); }
+
+	TArray<float> CurrentYaw;
+	TArray<float> StartYaw;
+	TArray<float> TargetYaw;
+	TArray<float> Alpha;
+
+	/* The solved yaw of every turn. */
+	TArray<float> OutYaw;
+
+	/* How far each turn moved from its current yaw, passed to TurnAnimation. */
+	TArray<float> OutDeltaYaw;
+};
+
+/**
+ * Owns the turns of every batched USPTurnToTask in the world and ticks them together at SP.TurnTo.UpdateRate,
+ * instead of each Task rotating its actors one by one from its own tick.
+ * Turns far from every player and outside every player's view are updated less often (see SP.TurnTo.LOD.*).
+ */
+UCLASS()
+class FEATURE_SP_API USPTurnToSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* Takes over the turns of a running Task until RemoveTurns is called with the same scratchpad.
+	*  With bReplicateIntent, the server replicates each turn once through USPTurnIntentComponent instead of its rotation every tick.
+	*  With CurveTable, turns that have a matching curve no longer than TaskTimeRemaining follow it instead of the Task blend. */
+	void AddTurns(USPTurnToTaskScratchPad& ScratchPad, bool bReplicateIntent, const USPTurnInPlaceCurveTable* CurveTable = nullptr, float TaskTimeRemaining = TNumericLimits<float>::Max());
+
+	/* Simulates the turn replicated by the component, until RemoveTurns is called with it. Clients only.
+	*  Skipped while a local Task turns the same actor, a local turn also drops the replicated one. */
+	void AddReplicatedTurn(const USPTurnIntentComponent& IntentComponent);
+
+	/* Releases the turns added with the owner (a scratchpad or an intent component). */
+	void RemoveTurns(const UObject& Owner);
+
+	FORCEINLINE int32 GetNumTurns() const { return m_Turns.Num(); }
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+#if !UE_BUILD_SHIPPING
+	/* Turns spawned actors through StepTurns and through the per-task path, and logs the time per tick. See SP.TurnTo.Benchmark. */
+	static void RunBenchmark(UWorld* World, const TArray<FString>& Args);
+#endif
+
+private:
+	struct FActiveTurn;
+
+	/* Ends the intent of the turn and resets the rotate on spot state of replicated turns, before the turn is removed. */
+	static void ReleaseTurn(FActiveTurn& Turn);
+
+	struct FActiveTurn
+	{
+		/* The scratchpad of the Task instance that added the turn, or the intent component it was replicated through. */
+		FObjectKey Owner;
+
+		/* The scratchpad whose NumUnfinishedTurns counts this turn, not set for replicated turns. */
+		TWeakObjectPtr<USPTurnToTaskScratchPad> ScratchPad;
+
+		/* Set once the turn completed or its actor went away. */
+		bool bFinished = false;
+
+		TWeakObjectPtr<AActor> Actor;
+
+		/* Valid as long as Actor is. */
+		ISPActorInterface* SPActor = nullptr;
+
+		/* Only set for bTurnto. */
+		TWeakObjectPtr<ASPGameMonsterBase> MonsterPawn;
+
+		FAlphaBlend Blend;
+
+		float StartYaw = 0.0f;
+
+		float TargetYaw = 0.0f;
+
+		/* Last rotate on spot state we sent to MonsterPawn. */
+		bool bRotateOnSpot = false;
+
+		float RotateOnSpotDirection = 0.0f;
+
+		/* Time the turn has not been updated for, applied in one go on its next update. */
+		float PendingTime = 0.0f;
+
+		/* Seconds between updates for the significance bucket of the actor. */
+		float UpdateInterval = 0.0f;
+
+		/* Time until the bucket is evaluated again. */
+		float SignificanceCooldown = 0.0f;
+
+		/* Server only, set while clients simulate the turn from its intent. */
+		TWeakObjectPtr<USPTurnIntentComponent> IntentComponent;
+
+		/* Where the actor was when the intent began. */
+		FVector IntentLocation = FVector::ZeroVector;
+
+		/* The yaw we last wrote, to notice anything else turning the actor. */
+		float LastWrittenYaw = 0.0f;
+
+		/* Simulated from a replicated intent. */
+		bool bReplicated = false;
+
+		/* Set when the turn follows a turn in place curve instead of Blend. */
+		TWeakObjectPtr<const USPTurnInPlaceCurveTable> CurveTable;
+
+		int32 CurveIndex = INDEX_NONE;
+
+		float CurveTime = 0.0f;
+	};
+
+	/* Where a player looks from, gathered once per step. */
+	struct FPlayerView
+	{
+		FVector Location = FVector::ZeroVector;
+
+		FVector Direction = FVector::ForwardVector;
+
+		/* Cosine of half the camera FOV, anything with a larger dot product is in view. */
+		float CosHalfFOV = 0.0f;
+	};
+
+	/* Advances every unfinished turn by DeltaTime. */
+	void StepTurns(float DeltaTime);
+
+	/* Returns the update interval of the significance bucket the actor falls in. */
+	float GetSignificanceInterval(const AActor& Actor) const;
+
+	/* Reads the SP.TurnTo.LOD console variables again if they changed. */
+	void RefreshSignificanceBuckets();
+
+	/* Returns the turn in place curve the turn follows, if any. */
+	static const FSPTurnInPlaceCurve* GetCurve(const FActiveTurn& Turn);
+
+	static bool IsTurnComplete(const FActiveTurn& Turn);
+
+	/* Marks the turn finished and tells its Task. */
+	static void FinishTurn(FActiveTurn& Turn);
+
+	static float GetTurnTimeRemaining(const FActiveTurn& Turn);
+
+	/* Advances the turn and returns how far along it is. */
+	static float AdvanceTurn(FActiveTurn& Turn, float DeltaTime);
+
+	/* Ends the intent of turns the clients can no longer predict, so movement replication corrects them. */
+	void CheckIntentDivergence(FActiveTurn& Turn, const AActor& Actor);
+
+	/* Forwards the rotate on spot state to the monster, only when it changed. */
+	static void UpdateRotateOnSpot(FActiveTurn& Turn, float DeltaYaw);
+
+	TArray<FActiveTurn> m_Turns;
+
+	/* Indices in m_Turns of the turns in m_Solver. */
+	TArray<int32> m_SolvedTurns;
+
+	FSPTurnToBatchSolver m_Solver;
+
+	float m_TimeSinceStep = 0.0f;
+
+	/* View points of the players, gathered once per step. Dedicated servers render nothing, so this is how they tell what a player can see. */
+	TArray<FPlayerView> m_PlayerViews;
+
+	/* Squared upper distance of each significance bucket, the last bucket is everything beyond. */
+	TArray<float> m_BucketDistancesSquared;
+
+	/* Update interval of each significance bucket beyond the first. */
+	TArray<float> m_BucketIntervals;
+
+	/* GSPTurnToLODSettingsVersion the buckets were parsed at. */
+	int32 m_BucketSettingsVersion = 0;
+};
@@ -1,174 +1,261 @@
-﻿// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "Game/SPGame/Skill/Task/SPTurnToTask.h"
-#include "Game/SPGame/Character/SPGameCharacterBase.h"
-#include "Game/SPGame/Character/SPGameMonsterBase.h"
-#include "Game/SPGame/Monster/AnimInstance/SPMonsterAnimInstance.h"
-#include "Game/SPGame/State/StateData/SPStunStateData.h"
-#include "Game/SPGame/Utils/SPGameLibrary.h"
-#include "Game/SPGame/Utils/SPCharacterLibrary.h"
-
-
-#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
-
-USPTurnToTask::USPTurnToTask(const FObjectInitializer& ObjectInitializer)
-	:Super(ObjectInitializer),
-	m_MoveAnimState(false),
-	m_RotateByMasterFaceTo(false)
-{
-
-}
-
-USPTurnToTask::~USPTurnToTask()
-{
-}
-
-FString USPTurnToTask::GetModuleName_Implementation() const
-{
-	return TEXT("Feature.StarP.Script.System.Ability.Task.SPTurnToTask");
-}
-
-void USPTurnToTask::OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
-{
-	Super::OnTaskStart(Context);
-	OnTaskStartBP_Override(Context.Get());
-}
-
-void USPTurnToTask::OnTaskStartBP_Override_Implementation(const UAbleAbilityContext* Context) const
-{
-	if (m_MoveAnimState)
-	{
-		UAbleTurnToTaskScratchPad* ScratchPad = Cast<UAbleTurnToTaskScratchPad>(Context->GetScratchPadForTask(this));
-		if (!ScratchPad) return;
-		for (FTurnToTaskEntry& Entry : ScratchPad->InProgressTurn)
-		{
-			if (Entry.Actor.IsValid())
-			{
-				if (const USkeletalMeshComponent* MeshComponent = Cast<USkeletalMeshComponent>(Entry.Actor->GetComponentByClass(USkeletalMeshComponent::StaticClass())))
-				{
-					UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance();
-					if (USPMonsterAnimInstance* SPMonsterAnimInstance = Cast<USPMonsterAnimInstance>(AnimInstance))
-					{
-						SPMonsterAnimInstance->bMonsterCanTurn = true;
-					}
-				}
-			}
-		}
-	}
-}
-
-void USPTurnToTask::OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,
-	const EAbleAbilityTaskResult result) const
-{
-	Super::OnTaskEnd(Context, result);
-	OnTaskEndBP_Override(Context.Get(), result);
-}
-
-void USPTurnToTask::TurnToSetActorRotation(const TWeakObjectPtr<AActor> TargetActor, const FRotator& TargetRotation) const
-{
-	if (TargetActor.IsValid())
-	{
-		if (ISPActorInterface* SPActor = Cast<ISPActorInterface>(TargetActor))
-		{
-			FHitResult Result = FHitResult();
-			SPActor->SPSetActorRotation(TargetRotation, false, Result);
-		}
-		else
-		{
-			Super::TurnToSetActorRotation(TargetActor, TargetRotation);
-		}
-	}
-}
-
-void USPTurnToTask::TurnAnimation(const TWeakObjectPtr<AActor> TargetActor, const float DeltaYaw) const
-{
-    if(m_bTurnto)
-    {
-    	if (ASPGameMonsterBase * MonsterPawn =Cast<ASPGameMonsterBase>(TargetActor))
-    	{
-    		MonsterPawn->SetEnableRotateOnSpot(true);
-    		MonsterPawn->SetRotateOnSpotDirection(DeltaYaw);
-    	}
-    }
-	
-}
-
-void USPTurnToTask::OnTaskEndBP_Override_Implementation(const UAbleAbilityContext* Context,
-                                                        const EAbleAbilityTaskResult result) const
-{
-	if (m_MoveAnimState)
-	{
-		UAbleTurnToTaskScratchPad* ScratchPad = Cast<UAbleTurnToTaskScratchPad>(Context->GetScratchPadForTask(this));
-		if (!ScratchPad) return;
-		for (FTurnToTaskEntry& Entry : ScratchPad->InProgressTurn)
-		{
-			if (Entry.Actor.IsValid())
-			{
-				if (const USkeletalMeshComponent* MeshComponent = Cast<USkeletalMeshComponent>(Entry.Actor->GetComponentByClass(USkeletalMeshComponent::StaticClass())))
-				{
-					UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance();
-					if (USPMonsterAnimInstance* SPMonsterAnimInstance = Cast<USPMonsterAnimInstance>(AnimInstance))
-					{
-						if (SPMonsterAnimInstance->bMonsterCanTurn)
-						{
-							SPMonsterAnimInstance->bMonsterCanTurn = false;
-						}
-					}
-				}
-			}
-		}
-	}
-	if (m_bTurnto)
-	{
-		UAbleTurnToTaskScratchPad* ScratchPad = Cast<UAbleTurnToTaskScratchPad>(Context->GetScratchPadForTask(this));
-		if (!ScratchPad) return;
-		for (FTurnToTaskEntry& Entry : ScratchPad->InProgressTurn)
-		{
-			if (Entry.Actor.IsValid())
-			{
-				if (ASPGameMonsterBase * MonsterPawn = Cast<ASPGameMonsterBase>(Entry.Actor))
-				{
-					MonsterPawn->SetEnableRotateOnSpot(false);
-					MonsterPawn->SetRotateOnSpotDirection(0);
-				}
-			}
-		}
-	}
-}
-
-FRotator USPTurnToTask::GetTargetRotation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const AActor* Source, const AActor* Destination) const
-{
-	if (m_RotateByMasterFaceTo)
-	{
-		return GetTargetRotationByMasterFaceTo(Source);
-	}
-	return Super::GetTargetRotation(Context, Source, Destination);
-}
-
-FRotator USPTurnToTask::GetTargetRotationByMasterFaceTo(const AActor* Source) const
-{
-	FVector SourceLocation = Source->GetActorLocation();
-	FRotator SourceRotation = Source->GetActorRotation();
-
-	if (USkeletalMeshComponent* MeshComponent = Source->FindComponentByClass<USkeletalMeshComponent>())
-	{
-		SourceLocation = MeshComponent->GetComponentLocation();
-		SourceRotation = MeshComponent->GetComponentRotation();
-	}
-
-	if (ISPActorInterface* SPActor = Cast<ISPActorInterface>(const_cast<AActor*>(Source)))
-	{
-		if (AActor* MasterActor = SPActor->GetMaster())
-		{
-			if (ISPActorInterface* MasterSPActor = Cast<ISPActorInterface>(MasterActor))
-			{
-				SourceRotation = USPCharacterLibrary::GetActorRotation(MasterSPActor);
-			}
-		}
-	}
-
-	return SourceRotation;
-}
-
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SPGame/Skill/Task/SPTurnToTask.h"
+#include "Game/SPGame/Skill/Task/SPTurnToSubsystem.h"
+#include "Game/SPGame/Character/SPGameCharacterBase.h"
+#include "Game/SPGame/Character/SPGameMonsterBase.h"
+#include "Game/SPGame/Monster/AnimInstance/SPMonsterAnimInstance.h"
+#include "Game/SPGame/State/StateData/SPStunStateData.h"
+#include "Game/SPGame/Utils/SPGameLibrary.h"
+#include "Game/SPGame/Utils/SPCharacterLibrary.h"
+#include "ableAbility.h"
+#include "ableSubSystem.h"
+#include "UObject/ObjectKey.h"
+
+
+#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
+
+USPTurnToTask::USPTurnToTask(const FObjectInitializer& ObjectInitializer)
+	:Super(ObjectInitializer),
+	m_MoveAnimState(false),
+	m_RotateByMasterFaceTo(false),
+	m_BatchedTurn(false),
+	m_ReplicateTurnIntent(false),
+	m_TurnInPlaceCurves(nullptr)
+{
+
+}
+
+USPTurnToTask::~USPTurnToTask()
+{
+}
+
+FString USPTurnToTask::GetModuleName_Implementation() const
+{
+	return TEXT("Feature.StarP.Script.System.Ability.Task.SPTurnToTask");
+}
+
+void USPTurnToTask::OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
+{
+	Super::OnTaskStart(Context);
+
+	// Batched turns are registered here rather than in OnTaskStartBP_Override, so a Lua override can't leave them behind in USPTurnToSubsystem.
+	if (USPTurnToTaskScratchPad* ScratchPad = Context.IsValid() ? Cast<USPTurnToTaskScratchPad>(Context->GetScratchPadForTask(this)) : nullptr)
+	{
+		ScratchPad->ActorHandles.Reset();
+		ScratchPad->bTurnsBatched = false;
+		ScratchPad->NumUnfinishedTurns = 0;
+
+		if (m_MoveAnimState || m_bTurnto || m_BatchedTurn)
+		{
+			ScratchPad->ActorHandles.Reserve(ScratchPad->InProgressTurn.Num());
+			for (FTurnToTaskEntry& Entry : ScratchPad->InProgressTurn)
+			{
+				if (!Entry.Actor.IsValid())
+				{
+					continue;
+				}
+
+				FSPTurnToActorHandles& Handles = ScratchPad->ActorHandles.AddDefaulted_GetRef();
+				Handles.Actor = Entry.Actor;
+
+				if (m_bTurnto)
+				{
+					Handles.MonsterPawn = Cast<ASPGameMonsterBase>(Entry.Actor.Get());
+				}
+
+				if (m_BatchedTurn)
+				{
+					Handles.StartYaw = Entry.Actor->GetActorRotation().Yaw;
+					Handles.TargetYaw = Entry.Target.Yaw;
+				}
+			}
+		}
+
+		if (m_BatchedTurn)
+		{
+			if (USPTurnToSubsystem* TurnToSubsystem = GetWorld() ? GetWorld()->GetSubsystem<USPTurnToSubsystem>() : nullptr)
+			{
+				// Curves play in real time while the Task ends at an Ability time, so convert with the play rate.
+				const float PlayRate = FMath::Max(Context->GetAbility()->GetPlayRate(Context.Get()), KINDA_SMALL_NUMBER);
+				const float TaskTimeRemaining = FMath::Max(0.0f, GetEndTime() - Context->GetCurrentTime()) / PlayRate;
+				TurnToSubsystem->AddTurns(*ScratchPad, m_ReplicateTurnIntent, m_TurnInPlaceCurves, TaskTimeRemaining);
+			}
+		}
+	}
+
+	OnTaskStartBP_Override(Context.Get());
+}
+
+void USPTurnToTask::OnTaskStartBP_Override_Implementation(const UAbleAbilityContext* Context) const
+{
+	USPTurnToTaskScratchPad* ScratchPad = Cast<USPTurnToTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (!ScratchPad || !m_MoveAnimState) return;
+
+	for (FSPTurnToActorHandles& Handles : ScratchPad->ActorHandles)
+	{
+		if (const USkeletalMeshComponent* MeshComponent = Handles.Actor.IsValid() ? Handles.Actor->FindComponentByClass<USkeletalMeshComponent>() : nullptr)
+		{
+			if (USPMonsterAnimInstance* SPMonsterAnimInstance = Cast<USPMonsterAnimInstance>(MeshComponent->GetAnimInstance()))
+			{
+				SPMonsterAnimInstance->bMonsterCanTurn = true;
+				Handles.MonsterAnimInstance = SPMonsterAnimInstance;
+			}
+		}
+	}
+}
+
+void USPTurnToTask::OnTaskTick(const TWeakObjectPtr<const UAbleAbilityContext>& Context, float deltaTime) const
+{
+	// Batched turns are ticked by USPTurnToSubsystem.
+	const USPTurnToTaskScratchPad* ScratchPad = m_BatchedTurn ? Cast<USPTurnToTaskScratchPad>(Context->GetScratchPadForTask(this)) : nullptr;
+	if (!ScratchPad || !ScratchPad->bTurnsBatched)
+	{
+		Super::OnTaskTick(Context, deltaTime);
+	}
+}
+
+bool USPTurnToTask::IsDone(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
+{
+	const USPTurnToTaskScratchPad* ScratchPad = m_BatchedTurn ? Cast<USPTurnToTaskScratchPad>(Context->GetScratchPadForTask(this)) : nullptr;
+	if (ScratchPad && ScratchPad->bTurnsBatched)
+	{
+		return ScratchPad->NumUnfinishedTurns <= 0;
+	}
+
+	return Super::IsDone(Context);
+}
+
+void USPTurnToTask::OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,
+	const EAbleAbilityTaskResult result) const
+{
+	Super::OnTaskEnd(Context, result);
+
+	USPTurnToTaskScratchPad* ScratchPad = Context.IsValid() ? Cast<USPTurnToTaskScratchPad>(Context->GetScratchPadForTask(this)) : nullptr;
+	if (ScratchPad && ScratchPad->bTurnsBatched)
+	{
+		if (USPTurnToSubsystem* TurnToSubsystem = GetWorld() ? GetWorld()->GetSubsystem<USPTurnToSubsystem>() : nullptr)
+		{
+			TurnToSubsystem->RemoveTurns(*ScratchPad);
+		}
+	}
+
+	OnTaskEndBP_Override(Context.Get(), result);
+
+	if (ScratchPad)
+	{
+		ScratchPad->ActorHandles.Reset();
+		ScratchPad->bTurnsBatched = false;
+		ScratchPad->NumUnfinishedTurns = 0;
+	}
+}
+
+void USPTurnToTask::TurnToSetActorRotation(const TWeakObjectPtr<AActor> TargetActor, const FRotator& TargetRotation) const
+{
+	if (TargetActor.IsValid())
+	{
+		if (ISPActorInterface* SPActor = Cast<ISPActorInterface>(TargetActor))
+		{
+			FHitResult Result = FHitResult();
+			SPActor->SPSetActorRotation(TargetRotation, false, Result);
+		}
+		else
+		{
+			Super::TurnToSetActorRotation(TargetActor, TargetRotation);
+		}
+	}
+}
+
+void USPTurnToTask::TurnAnimation(const TWeakObjectPtr<AActor> TargetActor, const float DeltaYaw) const
+{
+    if(m_bTurnto)
+    {
+    	if (ASPGameMonsterBase * MonsterPawn =Cast<ASPGameMonsterBase>(TargetActor))
+    	{
+    		MonsterPawn->SetEnableRotateOnSpot(true);
+    		MonsterPawn->SetRotateOnSpotDirection(DeltaYaw);
+    	}
+    }
+	
+}
+
+void USPTurnToTask::OnTaskEndBP_Override_Implementation(const UAbleAbilityContext* Context,
+                                                        const EAbleAbilityTaskResult result) const
+{
+	USPTurnToTaskScratchPad* ScratchPad = Cast<USPTurnToTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (!ScratchPad) return;
+
+	// Handles were resolved at start, only for the options that need them.
+	for (const FSPTurnToActorHandles& Handles : ScratchPad->ActorHandles)
+	{
+		if (USPMonsterAnimInstance* SPMonsterAnimInstance = Handles.MonsterAnimInstance.Get())
+		{
+			SPMonsterAnimInstance->bMonsterCanTurn = false;
+		}
+
+		if (ASPGameMonsterBase* MonsterPawn = Handles.MonsterPawn.Get())
+		{
+			MonsterPawn->SetEnableRotateOnSpot(false);
+			MonsterPawn->SetRotateOnSpotDirection(0);
+		}
+	}
+}
+
+UAbleAbilityTaskScratchPad* USPTurnToTask::CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const
+{
+	if (UAbleAbilityUtilitySubsystem* Subsystem = Context->GetUtilitySubsystem())
+	{
+		static TSubclassOf<UAbleAbilityTaskScratchPad> ScratchPadClass = USPTurnToTaskScratchPad::StaticClass();
+		return Subsystem->FindOrConstructTaskScratchPad(ScratchPadClass);
+	}
+
+	return NewObject<USPTurnToTaskScratchPad>(Context.Get());
+}
+
+FRotator USPTurnToTask::GetTargetRotation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const AActor* Source, const AActor* Destination) const
+{
+	if (m_RotateByMasterFaceTo)
+	{
+		return GetTargetRotationByMasterFaceTo(Source);
+	}
+	return Super::GetTargetRotation(Context, Source, Destination);
+}
+
+FRotator USPTurnToTask::GetTargetRotationByMasterFaceTo(const AActor* Source) const
+{
+	// The master's facing wins whenever there is one, so look it up first and skip the mesh entirely.
+	if (ISPActorInterface* SPActor = Cast<ISPActorInterface>(const_cast<AActor*>(Source)))
+	{
+		if (AActor* MasterActor = SPActor->GetMaster())
+		{
+			if (ISPActorInterface* MasterSPActor = Cast<ISPActorInterface>(MasterActor))
+			{
+				// Every summon of a master turns to the same facing, so look it up once per frame.
+				static uint64 CachedFrame = 0;
+				static TMap<FObjectKey, FRotator> MasterRotations;
+				if (CachedFrame != GFrameCounter)
+				{
+					CachedFrame = GFrameCounter;
+					MasterRotations.Reset();
+				}
+
+				if (const FRotator* CachedRotation = MasterRotations.Find(FObjectKey(MasterActor)))
+				{
+					return *CachedRotation;
+				}
+
+				return MasterRotations.Add(FObjectKey(MasterActor), USPCharacterLibrary::GetActorRotation(MasterSPActor));
+			}
+		}
+	}
+
+	if (const USkeletalMeshComponent* MeshComponent = Source->FindComponentByClass<USkeletalMeshComponent>())
+	{
+		return MeshComponent->GetComponentRotation();
+	}
+
+	return Source->GetActorRotation();
+}
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
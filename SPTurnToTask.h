@@ -1,65 +1,131 @@
-﻿// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "UnLuaInterface.h"
-#include "CoreMinimal.h"
-#include "Tasks/IAbleAbilityTask.h"
-#include "Tasks/ableTurnToTask.h"
-#include "SPTurnToTask.generated.h"
-
-
-#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
-/**
- * 
- */
-UCLASS()
-class FEATURE_SP_API USPTurnToTask : public UAbleTurnToTask
-{
-	GENERATED_BODY()
-
-protected:
-	virtual FString GetModuleName_Implementation() const override;
-
-public:
-
-	USPTurnToTask(const FObjectInitializer& ObjectInitializer);
-	virtual ~USPTurnToTask() override;
-	
-	virtual void OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
-	UFUNCTION(BlueprintNativeEvent)
-	void OnTaskStartBP_Override(const UAbleAbilityContext* Context) const;
-
-	virtual void OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,const EAbleAbilityTaskResult result) const override;
-	UFUNCTION(BlueprintNativeEvent)
-	void OnTaskEndBP_Override(const UAbleAbilityContext* Context,const EAbleAbilityTaskResult result) const;
-
-	virtual void TurnToSetActorRotation(const TWeakObjectPtr<AActor> TargetActor, const FRotator& TargetRotation) const override;
-	
-	virtual void TurnAnimation(const TWeakObjectPtr<AActor> TargetActor, const float DeltaYaw) const override;
-	
-	
-	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "ABP Anim State"))
-	bool m_MoveAnimState;
-
-	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "RotateByMasterFaceTo"))
-	bool m_RotateByMasterFaceTo;
-
-	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "bTurnto"))
-	bool m_bTurnto;
-#if WITH_EDITOR
-
-	virtual FText GetTaskCategory() const override { return LOCTEXT("USPTurnToTask", "Movement"); }
-
-	virtual FText GetTaskName() const override { return LOCTEXT("USPTurnToTask", "SP Turn To"); }
-
-#endif
-
-protected:
-	virtual FRotator GetTargetRotation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const AActor* Source, const AActor* Destination) const override;
-	FRotator GetTargetRotationByMasterFaceTo(const AActor* Source) const;
-};
-
-#undef LOCTEXT_NAMESPACE
-
-
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "UnLuaInterface.h"
+#include "CoreMinimal.h"
+#include "Tasks/IAbleAbilityTask.h"
+#include "Tasks/ableTurnToTask.h"
+#include "SPTurnToTask.generated.h"
+
+
+#define LOCTEXT_NAMESPACE "SPSkillAbilityTask"
+
+class ASPGameMonsterBase;
+class USPMonsterAnimInstance;
+class USPTurnInPlaceCurveTable;
+
+/* Handles of a turning actor, resolved once when the Task starts. */
+USTRUCT()
+struct FEATURE_SP_API FSPTurnToActorHandles
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<AActor> Actor;
+
+	/* Only resolved for ABP Anim State. */
+	UPROPERTY()
+	TWeakObjectPtr<USPMonsterAnimInstance> MonsterAnimInstance;
+
+	/* Only resolved for bTurnto. */
+	UPROPERTY()
+	TWeakObjectPtr<ASPGameMonsterBase> MonsterPawn;
+
+	/* Only set for Batched Turn. */
+	UPROPERTY()
+	float StartYaw = 0.0f;
+
+	UPROPERTY()
+	float TargetYaw = 0.0f;
+};
+
+UCLASS(Transient)
+class FEATURE_SP_API USPTurnToTaskScratchPad : public UAbleTurnToTaskScratchPad
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(transient)
+	TArray<FSPTurnToActorHandles> ActorHandles;
+
+	/* Set once USPTurnToSubsystem took over our turns. */
+	UPROPERTY(transient)
+	bool bTurnsBatched = false;
+
+	/* Batched turns USPTurnToSubsystem has not finished yet, kept up to date by the subsystem. */
+	UPROPERTY(transient)
+	int32 NumUnfinishedTurns = 0;
+};
+
+/**
+ * 
+ */
+UCLASS()
+class FEATURE_SP_API USPTurnToTask : public UAbleTurnToTask
+{
+	GENERATED_BODY()
+
+protected:
+	virtual FString GetModuleName_Implementation() const override;
+
+public:
+
+	USPTurnToTask(const FObjectInitializer& ObjectInitializer);
+	virtual ~USPTurnToTask() override;
+	
+	virtual void OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
+	UFUNCTION(BlueprintNativeEvent)
+	void OnTaskStartBP_Override(const UAbleAbilityContext* Context) const;
+
+	virtual void OnTaskTick(const TWeakObjectPtr<const UAbleAbilityContext>& Context, float deltaTime) const override;
+
+	/* Batched turns are done once USPTurnToSubsystem finished all of them, our own blend is never advanced. */
+	virtual bool IsDone(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
+
+	virtual void OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context,const EAbleAbilityTaskResult result) const override;
+	UFUNCTION(BlueprintNativeEvent)
+	void OnTaskEndBP_Override(const UAbleAbilityContext* Context,const EAbleAbilityTaskResult result) const;
+
+	virtual void TurnToSetActorRotation(const TWeakObjectPtr<AActor> TargetActor, const FRotator& TargetRotation) const override;
+	
+	virtual void TurnAnimation(const TWeakObjectPtr<AActor> TargetActor, const float DeltaYaw) const override;
+
+	virtual UAbleAbilityTaskScratchPad* CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const override;
+	
+	
+	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "ABP Anim State"))
+	bool m_MoveAnimState;
+
+	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "RotateByMasterFaceTo"))
+	bool m_RotateByMasterFaceTo;
+
+	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "bTurnto"))
+	bool m_bTurnto;
+
+	/* Hand our turns to USPTurnToSubsystem, which ticks every batched turn in the world together. Only the yaw is turned. */
+	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "Batched Turn"))
+	bool m_BatchedTurn;
+
+	/* Replicate the turn once (start, target, blend and start time) and let clients simulate it, instead of replicating the rotation every tick. Movement replication resumes if the actor diverges. */
+	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "Replicate Turn Intent", EditCondition = "m_BatchedTurn"))
+	bool m_ReplicateTurnIntent;
+
+	/* Turn in place curves of the monster. Batched turns with a matching curve follow the animation's yaw instead of the blend. */
+	UPROPERTY(EditAnywhere, Category = "Turn To", meta = (DisplayName = "Turn In Place Curves", EditCondition = "m_BatchedTurn"))
+	USPTurnInPlaceCurveTable* m_TurnInPlaceCurves;
+#if WITH_EDITOR
+
+	virtual FText GetTaskCategory() const override { return LOCTEXT("USPTurnToTask", "Movement"); }
+
+	virtual FText GetTaskName() const override { return LOCTEXT("USPTurnToTask", "SP Turn To"); }
+
+#endif
+
+protected:
+	virtual FRotator GetTargetRotation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const AActor* Source, const AActor* Destination) const override;
+	FRotator GetTargetRotationByMasterFaceTo(const AActor* Source) const;
+};
+
+#undef LOCTEXT_NAMESPACE
+
+
@@ -0,0 +1,184 @@
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#include "ableAnimTickOverrideSubsystem.h"
+
+#include "AbleCoreSPPrivate.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/OutputDevice.h"
+
+static TAutoConsoleVariable<int32> CVarAbleAnimTickOverrideServerBudget(
+	TEXT("Able.AnimTickOverride.ServerBudget"),
+	0,
+	TEXT("Maximum number of meshes a dedicated server lets Tasks force to tick their pose. 0 means no limit."));
+
+static FAutoConsoleCommandWithWorld AbleAnimTickOverrideDumpCommand(
+	TEXT("Able.AnimTickOverride.Dump"),
+	TEXT("Logs every Visibility Based Anim Tick override currently applied by Tasks."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UAbleAnimTickOverrideSubsystem* Subsystem = World ? World->GetSubsystem<UAbleAnimTickOverrideSubsystem>() : nullptr)
+		{
+			Subsystem->DumpOverrides(*GLog);
+		}
+	}));
+
+int32 UAbleAnimTickOverrideSubsystem::PushOverride(USkeletalMeshComponent* MeshComponent, EVisibilityBasedAnimTickOption Option, int32 Priority)
+{
+	if (!MeshComponent)
+	{
+		return INDEX_NONE;
+	}
+
+	const FObjectKey MeshKey(MeshComponent);
+	FMeshOverride* Override = m_Overrides.Find(MeshKey);
+
+	const int32 Budget = CVarAbleAnimTickOverrideServerBudget.GetValueOnGameThread();
+	const bool bCountsAgainstBudget = Budget > 0 && IsForcedTick(Option) && !(Override && Override->bForcedTick) && GetWorld()->GetNetMode() == NM_DedicatedServer;
+	if (bCountsAgainstBudget && m_NumForcedTickMeshes >= Budget)
+	{
+		// Destroyed meshes may still hold slots, only pay for the scan when they could matter.
+		PruneStaleOverrides();
+	}
+
+	if (bCountsAgainstBudget && m_NumForcedTickMeshes >= Budget)
+	{
+		UE_LOG(LogAbleSP, Verbose, TEXT("Anim tick override on %s rejected, %d meshes are already forced to tick."), *GetPathNameSafe(MeshComponent), m_NumForcedTickMeshes);
+		return INDEX_NONE;
+	}
+
+	if (!Override)
+	{
+		Override = &m_Overrides.Add(MeshKey);
+		Override->Mesh = MeshComponent;
+		Override->OriginalOption = MeshComponent->VisibilityBasedAnimTickOption;
+	}
+
+	const int32 Handle = m_NextHandle++;
+	Override->Requests.Add(FRequest{ Handle, Priority, Option });
+	m_HandleToMesh.Add(Handle, MeshKey);
+
+	Apply(*Override);
+	return Handle;
+}
+
+void UAbleAnimTickOverrideSubsystem::PopOverride(int32 Handle)
+{
+	FObjectKey MeshKey;
+	if (!m_HandleToMesh.RemoveAndCopyValue(Handle, MeshKey))
+	{
+		return;
+	}
+
+	if (FMeshOverride* Override = m_Overrides.Find(MeshKey))
+	{
+		Override->Requests.RemoveAll([Handle](const FRequest& Request) { return Request.Handle == Handle; });
+		Apply(*Override);
+
+		if (Override->Requests.Num() == 0)
+		{
+			m_Overrides.Remove(MeshKey);
+		}
+	}
+}
+
+void UAbleAnimTickOverrideSubsystem::PruneStaleOverrides()
+{
+	for (auto It = m_Overrides.CreateIterator(); It; ++It)
+	{
+		FMeshOverride& Override = It.Value();
+		if (Override.Mesh.IsValid())
+		{
+			continue;
+		}
+
+		for (const FRequest& Request : Override.Requests)
+		{
+			m_HandleToMesh.Remove(Request.Handle);
+		}
+
+		if (Override.bForcedTick)
+		{
+			--m_NumForcedTickMeshes;
+		}
+
+		It.RemoveCurrent();
+	}
+}
+
+void UAbleAnimTickOverrideSubsystem::Apply(FMeshOverride& Override)
+{
+	EVisibilityBasedAnimTickOption Option = Override.OriginalOption;
+
+	const FRequest* Winner = nullptr;
+	for (const FRequest& Request : Override.Requests)
+	{
+		// Later requests win ties.
+		if (!Winner || Request.Priority >= Winner->Priority)
+		{
+			Winner = &Request;
+		}
+	}
+
+	if (Winner)
+	{
+		Option = Winner->Option;
+	}
+
+	const bool bForcedTick = Override.Requests.Num() > 0 && IsForcedTick(Option);
+	if (bForcedTick != Override.bForcedTick)
+	{
+		m_NumForcedTickMeshes += bForcedTick ? 1 : -1;
+		Override.bForcedTick = bForcedTick;
+	}
+
+	if (USkeletalMeshComponent* MeshComponent = Override.Mesh.Get())
+	{
+		MeshComponent->VisibilityBasedAnimTickOption = Option;
+	}
+}
+
+bool UAbleAnimTickOverrideSubsystem::IsForcedTick(EVisibilityBasedAnimTickOption Option)
+{
+	return Option == EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones || Option == EVisibilityBasedAnimTickOption::AlwaysTickPose;
+}
+
+void UAbleAnimTickOverrideSubsystem::DumpOverrides(FOutputDevice& Ar) const
+{
+	const UEnum* OptionEnum = StaticEnum<EVisibilityBasedAnimTickOption>();
+
+	Ar.Logf(TEXT("Anim tick overrides: %d meshes, %d forced to tick."), m_Overrides.Num(), m_NumForcedTickMeshes);
+	for (const TPair<FObjectKey, FMeshOverride>& Entry : m_Overrides)
+	{
+		const FMeshOverride& Override = Entry.Value;
+		Ar.Logf(TEXT("  %s (original %s)"), *GetPathNameSafe(Override.Mesh.Get()), *OptionEnum->GetNameStringByValue((int64)Override.OriginalOption));
+		for (const FRequest& Request : Override.Requests)
+		{
+			Ar.Logf(TEXT("    [%d] priority %d: %s"), Request.Handle, Request.Priority, *OptionEnum->GetNameStringByValue((int64)Request.Option));
+		}
+	}
+}
+
+void UAbleAnimTickOverrideSubsystem::Deinitialize()
+{
+	for (TPair<FObjectKey, FMeshOverride>& Entry : m_Overrides)
+	{
+		if (USkeletalMeshComponent* MeshComponent = Entry.Value.Mesh.Get())
+		{
+			MeshComponent->VisibilityBasedAnimTickOption = Entry.Value.OriginalOption;
+		}
+	}
+
+	m_Overrides.Empty();
+	m_HandleToMesh.Empty();
+	m_NumForcedTickMeshes = 0;
+
+	Super::Deinitialize();
+}
+
+bool UAbleAnimTickOverrideSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Ability previews play animations too.
+	return Super::DoesSupportWorldType(WorldType) || WorldType == EWorldType::EditorPreview;
+}
@@ -0,0 +1,71 @@
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "ableAnimTickOverrideSubsystem.generated.h"
+
+class USkeletalMeshComponent;
+
+/* Owns every Visibility Based Anim Tick override Tasks apply to Skeletal Meshes.
+*  Requests are ref counted per mesh, the highest priority request wins (the most recent one on ties),
+*  and the original option is restored once the last request is released, regardless of the order Tasks end in. */
+UCLASS()
+class ABLECORESP_API UAbleAnimTickOverrideSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	/* Requests an override on the mesh. Returns the handle to release it with, or INDEX_NONE if the server budget rejected it. */
+	int32 PushOverride(USkeletalMeshComponent* MeshComponent, EVisibilityBasedAnimTickOption Option, int32 Priority);
+
+	/* Releases an override returned by PushOverride. */
+	void PopOverride(int32 Handle);
+
+	/* Returns how many meshes are currently forced to tick their pose by an override. */
+	FORCEINLINE int32 GetNumForcedTickMeshes() const { return m_NumForcedTickMeshes; }
+
+	/* Drops the overrides of meshes that were destroyed without their requests being released. */
+	void PruneStaleOverrides();
+
+	/* Writes every active override to the output device. */
+	void DumpOverrides(FOutputDevice& Ar) const;
+
+	/* Restores every mesh we still override. */
+	virtual void Deinitialize() override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FRequest
+	{
+		int32 Handle;
+		int32 Priority;
+		EVisibilityBasedAnimTickOption Option;
+	};
+
+	struct FMeshOverride
+	{
+		TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+		EVisibilityBasedAnimTickOption OriginalOption;
+		TArray<FRequest> Requests;
+		bool bForcedTick = false;
+	};
+
+	/* Applies the winning request (or the original option) to the mesh and keeps the forced tick count up to date. */
+	void Apply(FMeshOverride& Override);
+
+	static bool IsForcedTick(EVisibilityBasedAnimTickOption Option);
+
+	TMap<FObjectKey, FMeshOverride> m_Overrides;
+
+	TMap<int32, FObjectKey> m_HandleToMesh;
+
+	int32 m_NextHandle = 0;
+
+	int32 m_NumForcedTickMeshes = 0;
+};
@@ -0,0 +1,56 @@
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#include "ablePlayAnimationPreloadSubsystem.h"
+
+#include "ableAbility.h"
+#include "AbleCoreSPPrivate.h"
+
+void UAblePlayAnimationPreloadSubsystem::PreloadAbility(TSubclassOf<UAbleAbility> AbilityClass)
+{
+	const UAbleAbility* Ability = AbilityClass ? AbilityClass->GetDefaultObject<UAbleAbility>() : nullptr;
+	if (!Ability)
+	{
+		return;
+	}
+
+	FPreloadedAbility& Preloaded = m_Abilities.FindOrAdd(FObjectKey(*AbilityClass));
+	if (Preloaded.RefCount++ == 0)
+	{
+		Preloaded.Manifest.Gather(*Ability);
+		Preloaded.Manifest.RequestAsyncLoad();
+		UE_LOG(LogAbleSP, Verbose, TEXT("Preloading %d Animations of Ability %s."), Preloaded.Manifest.Assets.Num(), *GetNameSafe(*AbilityClass));
+	}
+}
+
+void UAblePlayAnimationPreloadSubsystem::ReleaseAbility(TSubclassOf<UAbleAbility> AbilityClass)
+{
+	const FObjectKey AbilityKey(*AbilityClass);
+	FPreloadedAbility* Preloaded = m_Abilities.Find(AbilityKey);
+	if (!Preloaded)
+	{
+		return;
+	}
+
+	if (--Preloaded->RefCount <= 0)
+	{
+		Preloaded->Manifest.Release();
+		m_Abilities.Remove(AbilityKey);
+	}
+}
+
+bool UAblePlayAnimationPreloadSubsystem::IsAbilityLoaded(TSubclassOf<UAbleAbility> AbilityClass) const
+{
+	const FPreloadedAbility* Preloaded = m_Abilities.Find(FObjectKey(*AbilityClass));
+	return Preloaded && Preloaded->Manifest.IsLoaded();
+}
+
+void UAblePlayAnimationPreloadSubsystem::Deinitialize()
+{
+	for (TPair<FObjectKey, FPreloadedAbility>& Entry : m_Abilities)
+	{
+		Entry.Value.Manifest.Release();
+	}
+	m_Abilities.Empty();
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,44 @@
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tasks/ablePlayAnimationTask.h"
+#include "UObject/ObjectKey.h"
+
+#include "ablePlayAnimationPreloadSubsystem.generated.h"
+
+class UAbleAbility;
+
+/* Streams in the Animations of an Ability's Play Animation Tasks when the Ability is granted/equipped, and keeps them resident until it is removed.
+*  Grant and equip code calls PreloadAbility / ReleaseAbility in pairs, the manifests are ref counted per Ability class. */
+UCLASS()
+class ABLECORESP_API UAblePlayAnimationPreloadSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+public:
+	/* Starts streaming the Animations of the Ability in. Call when the Ability is granted or equipped. */
+	UFUNCTION(BlueprintCallable, Category = "Able|Animation")
+	void PreloadAbility(TSubclassOf<UAbleAbility> AbilityClass);
+
+	/* Releases a PreloadAbility call. Call when the Ability is removed or unequipped. */
+	UFUNCTION(BlueprintCallable, Category = "Able|Animation")
+	void ReleaseAbility(TSubclassOf<UAbleAbility> AbilityClass);
+
+	/* Returns true once every Animation of a preloaded Ability is resident. */
+	UFUNCTION(BlueprintPure, Category = "Able|Animation")
+	bool IsAbilityLoaded(TSubclassOf<UAbleAbility> AbilityClass) const;
+
+	/* Releases every manifest we still hold. */
+	virtual void Deinitialize() override;
+
+private:
+	struct FPreloadedAbility
+	{
+		FAblePlayAnimationPreloadManifest Manifest;
+		int32 RefCount = 0;
+	};
+
+	TMap<FObjectKey, FPreloadedAbility> m_Abilities;
+};
@@ -1,781 +1,1702 @@
-﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
-
-#include "Tasks/ablePlayAnimationTask.h"
-
-#include "ableAbility.h"
-#include "ableAbilityBlueprintLibrary.h"
-#include "ableAbilityComponent.h"
-#include "ableSubSystem.h"
-#include "AbleCoreSPPrivate.h"
-#include "Animation/AnimInstance.h"
-#include "Animation/AnimInstanceProxy.h"
-#include "Animation/AnimMontage.h"
-#include "Animation/AnimNode_SPAbilityAnimPlayer.h"
-#include "Animation/AnimSequence.h"
-#include "Animation/AnimSingleNodeInstance.h"
-#include "Animation/AnimStateMachineTypes.h"
-#include "Animation/AnimNode_StateMachine.h"
-
-#include "Components/SkeletalMeshComponent.h"
-#include "GameFramework/Character.h"
-#include "Kismet/KismetSystemLibrary.h"
-
-#define LOCTEXT_NAMESPACE "AbleAbilityTask"
-
-UAblePlayAnimationTaskScratchPad::UAblePlayAnimationTaskScratchPad()
-{
-
-}
-
-UAblePlayAnimationTaskScratchPad::~UAblePlayAnimationTaskScratchPad()
-{
-
-}
-
-UAblePlayAnimationTask::UAblePlayAnimationTask(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer),
-	m_AnimationAsset(nullptr),
-	m_AnimationMontageSection(NAME_None),
-	m_OnEndAnimationMontageSection(NAME_None),
-	m_AnimationMode(EAblePlayAnimationTaskAnimMode::DynamicMontage),
-	m_StateMachineName(),
-	m_AbilityStateName(),
-	m_Loop(false),
-	m_SlotName(TEXT("DefaultSlot")),
-	m_TimeToStartMontageAt(0.0f),
-	m_BlendOutTriggerTime(-1.0f),
-	m_NumberOfLoops(1),
-	m_StopAllMontages(false),
-	m_PlayRate(1.0f),
-	m_ScaleWithAbilityPlayRate(true),
-	m_StopAnimationOnInterrupt(true),
-	m_ClearQueuedAnimationOnInterrupt(false),
-	m_ResetAnimationStateOnEnd(false),
-	m_ManuallySpecifyAnimationLength(false),
-	m_ManualLengthIsInterrupt(true),
-	m_EventName(NAME_None),
-	m_PlayOnServer(false),
-	m_OverrideVisibilityBasedAnimTick(false)
-{
-
-}
-
-UAblePlayAnimationTask::~UAblePlayAnimationTask()
-{
-
-}
-
-FString UAblePlayAnimationTask::GetModuleName_Implementation() const
-{
-	return TEXT("Feature.StarP.Script.System.Ability.Task.AblePlayAnimationTask");
-}
-
-void UAblePlayAnimationTask::OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
-{
-	Super::OnTaskStart(Context);
-	OnTaskStartBP(Context.Get());
-}
-
-void UAblePlayAnimationTask::OnTaskStartBP_Implementation(const UAbleAbilityContext* Context) const
-{
-
-	const UAnimationAsset* AnimationAsset = m_AnimationAsset.LoadSynchronous();
-
-	if (!AnimationAsset)
-	{
-		UE_LOG(LogAbleSP, Warning, TEXT("No Animation set for PlayAnimationTask in Ability [%s]"), *Context->GetAbility()->GetAbilityName());
-		return;
-	}
-
-	TArray<TWeakObjectPtr<AActor>> TargetArray;
-	GetActorsForTask(Context, TargetArray);
-
-	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
-	ScratchPad->AbilityComponents.Empty();
-	ScratchPad->SingleNodeSkeletalComponents.Empty();
-	ScratchPad->CachedVisibilityBasedAnimTickOptionMap.Empty();
-
-	float BasePlayRate = m_PlayRate;
-	float PlayRate = BasePlayRate * (m_ScaleWithAbilityPlayRate ? Context->GetAbility()->GetPlayRate(Context) : 1.0f);
-	FName MontageSection = m_AnimationMontageSection;
-
-	for (TWeakObjectPtr<AActor>& Target : TargetArray)
-	{
-		if (Target.IsValid())
-		{
-			if (USkeletalMeshComponent* PreferredComponent = Context->GetAbility()->GetSkeletalMeshComponentForActor(Context, Target.Get(), m_EventName))
-			{
-				PlayAnimation(Context, AnimationAsset, MontageSection, *Target.Get(), *ScratchPad, *PreferredComponent, PlayRate);
-			}
-			else
-			{
-				TInlineComponentArray<USkeletalMeshComponent*> InSkeletalComponents(Target.Get());
-
-				for (UActorComponent* SkeletalComponent : InSkeletalComponents)
-				{
-					PlayAnimation(Context, AnimationAsset, MontageSection, *Target.Get(), *ScratchPad, *Cast<USkeletalMeshComponent>(SkeletalComponent), PlayRate);
-				}
-			}
-			
-			if (m_OverrideVisibilityBasedAnimTick)
-			{
-				// Cached origin VisibilityBasesAnimTickOption for restore when animation ended.
-				if (USkeletalMeshComponent* TargetMesh = Target.Get()->FindComponentByClass<USkeletalMeshComponent>())
-				{
-					ScratchPad->CachedVisibilityBasedAnimTickOptionMap.Add(TargetMesh,TargetMesh->VisibilityBasedAnimTickOption);
-					TargetMesh->VisibilityBasedAnimTickOption = m_VisibilityBasedAnimTick;
-					if (UKismetSystemLibrary::IsDedicatedServer(this))
-					{
-						UAbleAbilityBlueprintLibrary::SetComponentTickEnableImplicitRef(TEXT("DynamicSetAnimationTickable"), TargetMesh, Context);
-					}
-				}
-			}
-		}
-	}
-}
-
-void UAblePlayAnimationTask::OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const EAbleAbilityTaskResult result) const
-{
-	Super::OnTaskEnd(Context, result);
-	OnTaskEndBP(Context.Get(), result);
-}
-
-void UAblePlayAnimationTask::OnTaskEndBP_Implementation(const UAbleAbilityContext* Context, const EAbleAbilityTaskResult result) const
-{
-
-	if (!Context)
-	{
-		return;
-	}
-
-	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
-	if (!ScratchPad) return;
-	
-	// Reset any Single Node instances that were previous AnimBlueprint mode.
-	for (TWeakObjectPtr<USkeletalMeshComponent>& SkeletalComponent : ScratchPad->SingleNodeSkeletalComponents)
-	{
-		if(SkeletalComponent == nullptr)
-			continue;
-		if (m_ResetAnimationStateOnEnd)
-		{
-			SkeletalComponent->SetAnimationMode(EAnimationMode::AnimationBlueprint);
-		}
-
-		// If we're in Animation Node mode, and our Ability was interrupted - tell the Animation Node.
-		if (m_StopAnimationOnInterrupt && (
-			(result == EAbleAbilityTaskResult::Interrupted || (result == EAbleAbilityTaskResult::BranchSegment && bStopAnimationOnBranch) || result == EAbleAbilityTaskResult::StopAcross) ||
-			(m_ManuallySpecifyAnimationLength && m_ManualLengthIsInterrupt) ) )
-		{
-			switch (m_AnimationMode)
-			{
-			case EAblePlayAnimationTaskAnimMode::AbilityAnimationNode:
-			{
-				if (FAnimNode_SPAbilityAnimPlayer* AnimPlayer = GetAbilityAnimGraphNode(Context, SkeletalComponent.Get()))
-				{
-					AnimPlayer->OnAbilityInterrupted(m_ClearQueuedAnimationOnInterrupt);
-				}
-			}
-			break;
-			case EAblePlayAnimationTaskAnimMode::DynamicMontage:
-			{
-				if (UAnimInstance* Instance = SkeletalComponent->GetAnimInstance())
-				{
-					FName MontageOnEnd = m_OnEndAnimationMontageSection;
-					if (MontageOnEnd != NAME_None)
-					{
-						Instance->Montage_JumpToSection(MontageOnEnd);
-					}
-					else
-					{
-						Instance->Montage_Stop(m_DynamicMontageBlend.m_BlendOut);
-					}
-				}
-			}
-			break;
-			case EAblePlayAnimationTaskAnimMode::SingleNode:
-			{
-				SkeletalComponent->SetAnimationMode(EAnimationMode::AnimationBlueprint);
-				if (UAnimSingleNodeInstance* SingleNode = SkeletalComponent->GetSingleNodeInstance())
-				{
-					SingleNode->StopAnim();
-				}
-			}
-			break;
-			default:
-				checkNoEntry();
-				break;
-			}
-
-		}
-
-		if (m_OverrideVisibilityBasedAnimTick && !ScratchPad->CachedVisibilityBasedAnimTickOptionMap.IsEmpty())
-		{
-			for (auto MeshIt = ScratchPad->CachedVisibilityBasedAnimTickOptionMap.CreateIterator(); MeshIt;++MeshIt)
-			{
-				if (MeshIt.Key().IsValid())
-				{
-					MeshIt.Key()->VisibilityBasedAnimTickOption = MeshIt.Value();
-					if (UKismetSystemLibrary::IsDedicatedServer(this))
-					{
-						UAbleAbilityBlueprintLibrary::SetComponentTickDisableImplicitRef(TEXT("DynamicSetAnimationTickable"), MeshIt.Key().Get(), Context);
-					}
-				}
-			}
-		}
-	}
-}
-
-
-bool UAblePlayAnimationTask::IsDone(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
-{
-	return Super::IsDone(Context);
-}
-
-bool UAblePlayAnimationTask::IsDoneBP_Implementation(const UAbleAbilityContext* Context) const
-{
-	float PlayRate = m_PlayRate;
-	return Context->GetCurrentTime() * PlayRate > GetEndTime();
-}
-
-float UAblePlayAnimationTask::GetEndTime() const
-{
-	if (m_ManuallySpecifyAnimationLength)
-	{
-		return Super::GetEndTime();
-	}
-	const UAnimationAsset* AnimationAsset = m_AnimationAsset.LoadSynchronous();
-	float PlayRate = m_PlayRate; // Assume a flat playrate. 
-	if (const UAnimMontage* Montage = Cast<UAnimMontage>(AnimationAsset))
-	{
-        if (m_AnimationMontageSection != NAME_None)
-        {
-            int32 sectionIndex = Montage->GetSectionIndex(m_AnimationMontageSection);
-            if (sectionIndex != INDEX_NONE)
-            {
-                const FCompositeSection& section = Montage->CompositeSections[sectionIndex];
-                float sequenceLength = (Montage->GetSectionLength(sectionIndex) * (1.0f / PlayRate));
-                
-                float endTime = GetStartTime() + sequenceLength;
-                return m_Loop ? FMath::Max(Super::GetEndTime(), endTime) : endTime;
-            }
-        }
-
-        float endTime = GetStartTime() + (const_cast<UAnimMontage*>(Montage)->GetPlayLength() * (1.0f / PlayRate));
-        return m_Loop ? FMath::Max(Super::GetEndTime(), endTime) : endTime;
-	}
-    else if (const UAnimSequenceBase* Sequence = Cast<UAnimSequenceBase>(AnimationAsset))
-    {
-        float endTime = GetStartTime() + (const_cast<UAnimSequenceBase*>(Sequence)->GetPlayLength() * (1.0f / PlayRate));
-        return m_Loop ? FMath::Max(Super::GetEndTime(), endTime) : endTime;
-    }
-    
-    // fallback
-    float endTime = GetStartTime() + 1.0f;
-    return m_Loop ? FMath::Max(Super::GetEndTime(), endTime) : endTime;
-}
-
-UAbleAbilityTaskScratchPad* UAblePlayAnimationTask::CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const
-{
-	if (UAbleAbilityUtilitySubsystem* Subsystem = Context->GetUtilitySubsystem())
-	{
-		static TSubclassOf<UAbleAbilityTaskScratchPad> ScratchPadClass = UAblePlayAnimationTaskScratchPad::StaticClass();
-		return Subsystem->FindOrConstructTaskScratchPad(ScratchPadClass);
-	}
-
-	return NewObject<UAblePlayAnimationTaskScratchPad>(Context.Get());
-}
-
-TStatId UAblePlayAnimationTask::GetStatId() const
-{
-	 RETURN_QUICK_DECLARE_CYCLE_STAT(UAblePlayAnimationTask, STATGROUP_Able);
-}
-
-void UAblePlayAnimationTask::SetAnimationAsset(UAnimationAsset* Animation)
-{
-	check(Animation->IsA<UAnimSequenceBase>() || Animation->IsA<UAnimMontage>());
-	m_AnimationAsset = Animation;
-}
-
-void UAblePlayAnimationTask::OnAbilityPlayRateChanged(const UAbleAbilityContext* Context, float NewPlayRate)
-{
-	Super::OnAbilityPlayRateChanged(Context, NewPlayRate);
-	if (!Context)
-	{
-		return;
-	}
-	TArray<TWeakObjectPtr<AActor>> TargetArray;
-	GetActorsForTask(Context, TargetArray);
-	for (TWeakObjectPtr<AActor>& Target : TargetArray)
-	{
-		if (Target.IsValid())
-		{
-			if (USkeletalMeshComponent* PreferredComponent = Context->GetAbility()->GetSkeletalMeshComponentForActor(Context, Target.Get(), m_EventName))
-			{
-				SetAnimationPlayRateInRunTime(Context, *PreferredComponent, NewPlayRate);
-			}
-			else
-			{
-				TInlineComponentArray<USkeletalMeshComponent*> InSkeletalComponents(Target.Get());
-
-				for (USkeletalMeshComponent* SkeletalComponent : InSkeletalComponents)
-				{
-					SetAnimationPlayRateInRunTime(Context, *SkeletalComponent, NewPlayRate);
-				}
-			}
-		}
-	}
-}
-
-void UAblePlayAnimationTask::PlayAnimation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const UAnimationAsset* AnimationAsset, const FName& MontageSection, AActor& TargetActor, UAblePlayAnimationTaskScratchPad& ScratchPad, USkeletalMeshComponent& SkeletalMeshComponent, float PlayRate) const
-{
-	switch (m_AnimationMode.GetValue())
-	{
-		case EAblePlayAnimationTaskAnimMode::SingleNode:
-		{
-			// Make a note of these so we can reset to Animation Blueprint mode.
-			if (SkeletalMeshComponent.GetAnimationMode() == EAnimationMode::AnimationBlueprint)
-			{
-				ScratchPad.SingleNodeSkeletalComponents.Add(&SkeletalMeshComponent);
-			}
-
-			if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(AnimationAsset))
-			{
-				if (UAnimInstance* Instance = SkeletalMeshComponent.GetAnimInstance())
-				{
-#if !(UE_BUILD_SHIPPING)
-					if (IsVerbose())
-					{
-						PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Montage %s (Section %s) on Target %s"), 
-                            *MontageAsset->GetName(), *MontageSection.ToString(), *TargetActor.GetName()));
-					}
-#endif
-					float StartMontageAt = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_TimeToStartMontageAt);
-
-					ScratchPad.CurrentAnimMontage = const_cast<UAnimMontage*>(MontageAsset);
-					Instance->Montage_Play(ScratchPad.CurrentAnimMontage.Get(), PlayRate, EMontagePlayReturnType::MontageLength, StartMontageAt, ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StopAllMontages));
-
-                    if (MontageSection != NAME_None)
-                    {
-#if !(UE_BUILD_SHIPPING)
-                        if (!MontageAsset->IsValidSectionName(MontageSection))
-                        {
-                            PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Montage %s (Section %s) on Target %s Invalid Montage Section"),
-                                *MontageAsset->GetName(), *MontageSection.ToString(), *TargetActor.GetName()));
-                        }
-#endif
-
-                        Instance->Montage_JumpToSection(MontageSection, MontageAsset);
-                    }
-				}
-			}
-			else if (UAnimSingleNodeInstance* SingleNode = SkeletalMeshComponent.GetSingleNodeInstance()) // See if we already have an instance instantiated.
-			{
-#if !(UE_BUILD_SHIPPING)
-				if (IsVerbose())
-				{
-					PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Animation %s on Target %s"), *AnimationAsset->GetName(), *TargetActor.GetName()));
-				}
-#endif
-				SingleNode->SetAnimationAsset(const_cast<UAnimationAsset*>(AnimationAsset), m_Loop, PlayRate);
-				SingleNode->PlayAnim(m_Loop);
-			}
-			else // Nope, start a new one.
-			{
-#if !(UE_BUILD_SHIPPING)
-				if (IsVerbose())
-				{
-					PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Animation %s on Target %s"), *AnimationAsset->GetName(), *TargetActor.GetName()));
-				}
-#endif
-				SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationSingleNode);
-				SkeletalMeshComponent.SetAnimation(const_cast<UAnimationAsset*>(AnimationAsset));
-				SkeletalMeshComponent.SetPlayRate(PlayRate);
-				SkeletalMeshComponent.Play(m_Loop);
-			}
-		}
-		break;
-		case EAblePlayAnimationTaskAnimMode::AbilityAnimationNode:
-		{
-			if (SkeletalMeshComponent.GetAnimationMode() != EAnimationMode::AnimationBlueprint)
-			{
-				SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationBlueprint);
-			}
-			
-			if (UAnimInstance* Instance = SkeletalMeshComponent.GetAnimInstance())
-			{
-				const UWorld* World= GetWorld();
-				if (World && World->IsGameWorld())
-				{
-					const UAnimSequence* AnimationSequence = Cast<UAnimSequence>(AnimationAsset);
-					if (AnimationSequence)
-					{
-						if (FAnimNode_SPAbilityAnimPlayer* AbilityPlayerNode = GetAbilityAnimGraphNode(Context, &SkeletalMeshComponent))
-						{
-#if !(UE_BUILD_SHIPPING)
-							if (IsVerbose())
-							{
-								PrintVerbose(Context, FString::Printf(TEXT("Playing Animation %s on Target %s using Ability Animation Node"), *AnimationAsset->GetName(), *TargetActor.GetName()));
-							}
-#endif
-							AbilityPlayerNode->PlayAnimationSequence(AnimationSequence, PlayRate, m_BlendIn, m_BlendOut);
-
-							if (UAbleAbilityComponent* AbilityComponent = TargetActor.FindComponentByClass<UAbleAbilityComponent>())
-							{
-								ScratchPad.AbilityComponents.Add(AbilityComponent);
-
-								AbilityComponent->SetAbilityAnimationNode(AbilityPlayerNode);
-							}
-						}
-						else
-						{
-							UE_LOG(LogAbleSP, Warning, TEXT("Failed to find Ability Animation Node using State Machine Name %s and Node Name %s"), *m_StateMachineName.ToString(), *m_AbilityStateName.ToString());
-						}
-					}
-					else
-					{
-						UE_LOG(LogAbleSP, Warning, TEXT("Ability Animation Node only supports Animation Sequences. Unable to play %s"), *AnimationAsset->GetName());
-					}
-				}
-				else
-				{
-					// Use play animation single node instead since no matter what, this timing is just for preview.
-					SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationSingleNode);
-					SkeletalMeshComponent.SetAnimation(const_cast<UAnimationAsset*>(AnimationAsset));
-					SkeletalMeshComponent.SetPlayRate(PlayRate);
-					SkeletalMeshComponent.Play(m_Loop);
-				}
-			}
-		}
-		break;
-		case EAblePlayAnimationTaskAnimMode::DynamicMontage:
-		{
-			if (SkeletalMeshComponent.GetAnimationMode() != EAnimationMode::AnimationBlueprint)
-			{
-				SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationBlueprint);
-			}
-
-			if (UAnimInstance* Instance = SkeletalMeshComponent.GetAnimInstance())
-			{
-				float StartMontageAt = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_TimeToStartMontageAt);
-				float BlendOutTimeAt = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_BlendOutTriggerTime);
-				int32 NumLoops = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_NumberOfLoops);
-				FName SlotName = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_SlotName);
-
-				if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(AnimationAsset))
-				{
-#if !(UE_BUILD_SHIPPING)
-					if (IsVerbose())
-					{
-						PrintVerbose(Context, FString::Printf(TEXT("Playing Montage Animation %s on Target %s using Dynamic Montage"), *MontageAsset->GetName(), *TargetActor.GetName()));
-					}
-#endif
-					ScratchPad.CurrentAnimMontage = const_cast<UAnimMontage*>(MontageAsset);
-					Instance->Montage_Play(ScratchPad.CurrentAnimMontage.Get(), PlayRate, EMontagePlayReturnType::MontageLength, StartMontageAt, ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StopAllMontages));
-				}
-				else if (const UAnimSequenceBase* SequenceAsset = Cast<UAnimSequenceBase>(AnimationAsset))
-				{
-#if !(UE_BUILD_SHIPPING)
-					if (IsVerbose())
-					{
-						PrintVerbose(Context, FString::Printf(TEXT("Playing Slot Animation %s on Target %s on Slot %s using Dynamic Montage"), *SequenceAsset->GetName(), *TargetActor.GetName(), *SlotName.ToString()));
-					}
-#endif
-					
-					const UWorld* World= GetWorld();
-					if (World && World->IsGameWorld())
-					{
-						//loop次数默认值为1
-						if (m_Loop && NumLoops <= 1)
-						{
-							//使用蒙太奇播放不会使用m_Loop，需要使用loop次数才能保持loop，动画会在TaskEnd结束时结束
-							NumLoops = INT_MAX;
-						}
-						const FAbleBlendTimes DynamicMontageBlend = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_DynamicMontageBlend);
-						ScratchPad.CurrentAnimMontage = PlayMontageBySequence(Instance, const_cast<UAnimSequenceBase*>(SequenceAsset), SlotName, DynamicMontageBlend.m_BlendIn, DynamicMontageBlend.m_BlendOut, PlayRate, NumLoops, BlendOutTimeAt, StartMontageAt, ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StopAllMontages));
-						// ScratchPad.CurrentAnimMontage = Instance->PlaySlotAnimationAsDynamicMontage(const_cast<UAnimSequenceBase*>(SequenceAsset), SlotName, DynamicMontageBlend.m_BlendIn, DynamicMontageBlend.m_BlendOut, PlayRate, NumLoops, BlendOutTimeAt, StartMontageAt);
-					}
-					else
-					{
-						// Use play animation single node instead since PlaySlotAnimationAsDynamicMontage() does not play animation in editor preview.
-						SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationSingleNode);
-						SkeletalMeshComponent.SetAnimation(const_cast<UAnimationAsset*>(AnimationAsset));
-						SkeletalMeshComponent.SetPlayRate(PlayRate);
-						SkeletalMeshComponent.Play(m_Loop);
-					}
-				}
-			}
-		}
-		break;
-		default:
-		{
-			checkNoEntry();
-		}
-		break;
-	}
-
-	if (m_StopAnimationOnInterrupt)
-	{
-		ScratchPad.SingleNodeSkeletalComponents.Add(&SkeletalMeshComponent);
-	}
-}
-
-void UAblePlayAnimationTask::SetAnimationPlayRateInRunTime(const UAbleAbilityContext* Context,
-	const USkeletalMeshComponent& MeshComp, float NewPlayRate) const
-{
-	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
-	if (!ScratchPad) return;
-	
-	switch (m_AnimationMode.GetValue())
-	{
-		case EAblePlayAnimationTaskAnimMode::SingleNode:
-		{
-			if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(GetAnimationAsset()))
-			{
-				if (UAnimInstance* AnimInstance = MeshComp.GetAnimInstance())
-				{
-					if(AnimInstance->GetCurrentActiveMontage() == MontageAsset)
-					{
-						AnimInstance->Montage_SetPlayRate(MontageAsset, NewPlayRate);
-					}
-				}
-			}
-			else
-			{
-				if (UAnimSingleNodeInstance* SingleNode = MeshComp.GetSingleNodeInstance())
-				{
-					SingleNode->SetPlayRate(NewPlayRate);
-				}
-			}
-			break;
-		}
-		case EAblePlayAnimationTaskAnimMode::DynamicMontage:
-		{
-			if (UAnimInstance* AnimInstance = MeshComp.GetAnimInstance())
-			{
-				if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(GetAnimationAsset()))
-				{
-					if(AnimInstance->GetCurrentActiveMontage() == MontageAsset)
-					{
-						AnimInstance->Montage_SetPlayRate(MontageAsset, NewPlayRate);
-					}
-				}
-				else
-				{
-					if (ScratchPad->CurrentAnimMontage.IsValid())
-					{
-						if(AnimInstance->GetCurrentActiveMontage() == ScratchPad->CurrentAnimMontage)
-						{
-							AnimInstance->Montage_SetPlayRate(ScratchPad->CurrentAnimMontage.Get(), NewPlayRate);
-						}
-					}
-					else
-					{
-						//Editor技能预览模式
-						if (UAnimSingleNodeInstance* SingleNode = MeshComp.GetSingleNodeInstance())
-						{
-							SingleNode->SetPlayRate(NewPlayRate);
-						}
-					}
-				}
-			}
-			break;
-		}
-	default: ;
-	}
-}
-
-UAnimMontage* UAblePlayAnimationTask::PlayMontageBySequence(UAnimInstance* Instance, UAnimSequenceBase* Asset, FName SlotNodeName,
-	float BlendInTime, float BlendOutTime, float InPlayRate, int32 LoopCount, float BlendOutTriggerTime,
-	float InTimeToStartMontageAt, bool bStopAllMontages, float Weight) const
-{
-	if (Asset && Instance)
-	{
-		return Instance->PlaySlotAnimationAsDynamicMontage(Asset, SlotNodeName, BlendInTime, BlendOutTime, InPlayRate, LoopCount, BlendOutTriggerTime, InTimeToStartMontageAt);
-	}
-	return nullptr;
-}
-
-FAnimNode_SPAbilityAnimPlayer* UAblePlayAnimationTask::GetAbilityAnimGraphNode(const TWeakObjectPtr<const UAbleAbilityContext>& Context, USkeletalMeshComponent* MeshComponent) const
-{
-	if (UAnimInstance* Instance = MeshComponent->GetAnimInstance())
-	{
-		FAnimInstanceProxy InstanceProxy(Instance);
-		FName StateMachineName = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StateMachineName);
-		FName AbilityStateName = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_AbilityStateName);
-
-		FAnimNode_StateMachine* StateMachineNode = InstanceProxy.GetStateMachineInstanceFromName(StateMachineName);
-		if (StateMachineNode)
-		{
-			const FBakedAnimationStateMachine* BakedStateMachine = InstanceProxy.GetMachineDescription(InstanceProxy.GetAnimClassInterface(), StateMachineNode);
-
-			if (BakedStateMachine)
-			{
-				for (const FBakedAnimationState& State : BakedStateMachine->States)
-				{
-					if (State.StateName == AbilityStateName)
-					{
-						for (const int32& PlayerNodeIndex : State.PlayerNodeIndices)
-						{
-							FAnimNode_SPAbilityAnimPlayer* AbilityPlayerNode = (FAnimNode_SPAbilityAnimPlayer*)InstanceProxy.GetNodeFromIndexUntyped(PlayerNodeIndex, FAnimNode_SPAbilityAnimPlayer::StaticStruct());
-							if (AbilityPlayerNode)
-							{
-								return AbilityPlayerNode;
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-
-	return nullptr;
-}
-
-void UAblePlayAnimationTask::OnAbilityTimeSet(const TWeakObjectPtr<const UAbleAbilityContext>& Context)
-{
-	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
-	if (!ScratchPad) return;
-
-	const UAnimationAsset* AnimationAsset = m_AnimationAsset.LoadSynchronous();
-	switch (m_AnimationMode.GetValue())
-	{
-	case EAblePlayAnimationTaskAnimMode::AbilityAnimationNode:
-	{
-		// Reset any Single Node instances that were previous AnimBlueprint mode.
-		for (TWeakObjectPtr<USkeletalMeshComponent>& SkeletalComponent : ScratchPad->SingleNodeSkeletalComponents)
-		{
-			if (FAnimNode_SPAbilityAnimPlayer* AbilityNode = GetAbilityAnimGraphNode(Context, SkeletalComponent.Get()))
-			{
-				AbilityNode->SetAnimationTime(Context->GetCurrentTime() - GetStartTime());
-			}
-		}
-	}
-	case EAblePlayAnimationTaskAnimMode::SingleNode:
-	{
-		for (TWeakObjectPtr<USkeletalMeshComponent>& SkeletalComponent : ScratchPad->SingleNodeSkeletalComponents)
-		{
-            if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(AnimationAsset))
-            {
-                if (UAnimInstance* Instance = SkeletalComponent->GetAnimInstance())
-                {
-                    if (m_AnimationMontageSection != NAME_None)
-                    {
-						FName MontageName = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_AnimationMontageSection);
-                        FAnimMontageInstance* MontageInstance = Instance->GetActiveInstanceForMontage(MontageAsset);
-                        if (MontageInstance)
-                        {
-                            bool const bEndOfSection = (MontageInstance->GetPlayRate() < 0.f);
-                            if (MontageInstance->JumpToSectionName(MontageName, bEndOfSection))
-                            {
-								const int32 SectionID = MontageAsset->GetSectionIndex(MontageName);
-
-                                if (MontageAsset->IsValidSectionIndex(SectionID))
-                                {
-                                    FCompositeSection & CurSection = const_cast<UAnimMontage*>(MontageAsset)->GetAnimCompositeSection(SectionID);
-                                    MontageInstance->SetPosition(CurSection.GetTime() + Context->GetCurrentTime() - GetStartTime());
-                                }
-                            }
-                        }
-                    }
-                    else
-                    {
-                        Instance->Montage_SetPosition(MontageAsset, Context->GetCurrentTime() - GetStartTime());
-                    }
-                }
-            }
-            else
-            {
-                if (UAnimSingleNodeInstance* SingleNode = SkeletalComponent->GetSingleNodeInstance())
-                {
-                    SingleNode->SetPosition(Context->GetCurrentTime() - GetStartTime());
-                }
-            }
-		}
-	}
-	break;
-	default:
-		break;
-	}
-}
-
-void UAblePlayAnimationTask::BindDynamicDelegates(UAbleAbility* Ability)
-{
-	Super::BindDynamicDelegates(Ability);
-
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_AnimationAsset, TEXT("Animation"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_DynamicMontageBlend, TEXT("Play Blend"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_PlayRate, TEXT("Play Rate"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_TimeToStartMontageAt, TEXT("Time To Start At"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_BlendOutTriggerTime, TEXT("Blend Out Trigger Time"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_NumberOfLoops, TEXT("Number Of Loops"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_StopAllMontages, TEXT("Stop All Montages"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_SlotName, TEXT("Slot Name"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_StateMachineName, TEXT("State Machine Name"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_AbilityStateName, TEXT("Ability State Name"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_AnimationMontageSection, TEXT("Montage Section"));
-	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_OnEndAnimationMontageSection, TEXT("Montage Section on End"));
-}
-
-#if WITH_EDITOR
-
-FText UAblePlayAnimationTask::GetDescriptiveTaskName() const
-{
-	const FText FormatText = LOCTEXT("AblePlayAnimationTaskFormat", "{0}: {1}");
-	FString AnimationName = TEXT("<null>");
-	const UAnimationAsset* AnimationAsset = m_AnimationAsset.LoadSynchronous();
-	if (AnimationAsset)
-	{
-        AnimationName = m_AnimationAsset->GetName();
-
-        if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(AnimationAsset))
-        {
-            if (m_AnimationMontageSection != NAME_None)
-            {
-                if(MontageAsset->IsValidSectionName(m_AnimationMontageSection))
-                    AnimationName = FString::Format(TEXT("{0}({1})"), { m_AnimationAsset->GetName(), m_AnimationMontageSection.ToString() });
-                else
-                    AnimationName = FString::Format(TEXT("{0}({1})"), { m_AnimationAsset->GetName(), TEXT("<InvalidSection>") });
-            }
-        }
-	}
-	else if (m_AnimationAssetDelegate.IsBound())
-	{
-		AnimationName = TEXT("Dynamic");
-	}
-
-	return FText::FormatOrdered(FormatText, GetTaskName(), FText::FromString(AnimationName));
-}
-
-FText UAblePlayAnimationTask::GetRichTextTaskSummary() const
-{
-	FTextBuilder StringBuilder;
-
-	StringBuilder.AppendLine(Super::GetRichTextTaskSummary());
-
-	FString AnimationName = TEXT("NULL");
-	if (m_AnimationAssetDelegate.IsBound())
-	{
-		AnimationName = FString::Format(TEXT("<a id=\"AbleTextDecorators.GraphReference\" style=\"RichText.Hyperlink\" GraphName=\"{0}\">Dynamic</>"), { m_AnimationAssetDelegate.GetFunctionName().ToString() });
-	}
-	else
-	{
-		AnimationName = FString::Format(TEXT("<a id=\"AbleTextDecorators.AssetReference\" style=\"RichText.Hyperlink\" PropertyName=\"m_AnimationAsset\" Filter=\"AnimationAsset\">{0}</>"), { !m_AnimationAsset.ToString().IsEmpty() ? m_AnimationAsset.ToString() : AnimationName });
-	}
-	StringBuilder.AppendLineFormat(LOCTEXT("AblePlayAnimationTaskRichFmt", "\t- Animation: {0}"), FText::FromString(AnimationName));
-
-	return StringBuilder.ToText();
-}
-
-EDataValidationResult UAblePlayAnimationTask::IsTaskDataValid(const UAbleAbility* AbilityContext, const FText& AssetName, TArray<FText>& ValidationErrors)
-{
-    EDataValidationResult result = EDataValidationResult::Valid;
-
-    return result;
-}
-
-#endif
-
-EAbleAbilityTaskRealm UAblePlayAnimationTask::GetTaskRealmBP_Implementation() const { return m_PlayOnServer ? EAbleAbilityTaskRealm::ATR_ClientAndServer : EAbleAbilityTaskRealm::ATR_Client; }
-
-#undef LOCTEXT_NAMESPACE
-
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#include "Tasks/ablePlayAnimationTask.h"
+
+#include "ableAbility.h"
+#include "ableAbilityContext.h"
+#include "ableAbilityBlueprintLibrary.h"
+#include "ableAbilityComponent.h"
+#include "ableAnimTickOverrideSubsystem.h"
+#include "ableSubSystem.h"
+#include "Tasks/ableCollisionQueryTask.h"
+#include "Tasks/ableCollisionSweepTask.h"
+#include "Tasks/ableRayCastQueryTask.h"
+#include "AbleCoreSPPrivate.h"
+#include "Animation/AnimClassInterface.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimNode_SPAbilityAnimPlayer.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/AnimSingleNodeInstance.h"
+#include "Animation/AnimStateMachineTypes.h"
+#include "Animation/SkeletalMeshActor.h"
+#include "Animation/AnimNode_StateMachine.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/AssetManager.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/Character.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "UObject/GCObject.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/ObjectSaveContext.h"
+#include "UObject/UObjectIterator.h"
+
+#define LOCTEXT_NAMESPACE "AbleAbilityTask"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Play Animation Sync Loads"), STAT_AblePlayAnimationSyncLoads, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Resolve Targets"), STAT_AblePlayAnimationResolveTargets, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Play Targets"), STAT_AblePlayAnimationPlayTargets, STATGROUP_Able);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Play Animation Targets"), STAT_AblePlayAnimationTargets, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Play Animation Target Cache Hits"), STAT_AblePlayAnimationTargetCacheHits, STATGROUP_Able);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Play Animation Per Target (ms)"), STAT_AblePlayAnimationPerTargetMs, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dynamic Montage Allocations"), STAT_AblePlayAnimationDynamicMontageAllocations, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dynamic Montage Cache Hits"), STAT_AblePlayAnimationDynamicMontageCacheHits, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Evaluate Server Pose"), STAT_AblePlayAnimationEvaluateServerPose, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Play Rate Changed"), STAT_AblePlayAnimationPlayRateChanged, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Seek"), STAT_AblePlayAnimationSeek, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Single Node"), STAT_AblePlayAnimationSingleNode, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Ability Animation Node"), STAT_AblePlayAnimationAbilityAnimationNode, STATGROUP_Able);
+DECLARE_CYCLE_STAT(TEXT("Play Animation Dynamic Montage"), STAT_AblePlayAnimationDynamicMontage, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Play Animation Single Node Plays"), STAT_AblePlayAnimationSingleNodePlays, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Play Animation Ability Animation Node Plays"), STAT_AblePlayAnimationAbilityAnimationNodePlays, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Play Animation Dynamic Montage Plays"), STAT_AblePlayAnimationDynamicMontagePlays, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Play Animation Single Node Fallbacks"), STAT_AblePlayAnimationSingleNodeFallbacks, STATGROUP_Able);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Play Animation Failed Node Lookups"), STAT_AblePlayAnimationFailedNodeLookups, STATGROUP_Able);
+
+// Headless servers can capture these with -trace=AblePlayAnimation,counters or the csvprofile console commands.
+UE_TRACE_CHANNEL_DEFINE(AblePlayAnimationChannel);
+CSV_DEFINE_CATEGORY(AblePlayAnimation, true);
+
+TRACE_DECLARE_INT_COUNTER(AblePlayAnimation_SyncLoads, TEXT("Able/PlayAnimation/SyncLoads"));
+TRACE_DECLARE_INT_COUNTER(AblePlayAnimation_SingleNodePlays, TEXT("Able/PlayAnimation/SingleNodePlays"));
+TRACE_DECLARE_INT_COUNTER(AblePlayAnimation_AbilityAnimationNodePlays, TEXT("Able/PlayAnimation/AbilityAnimationNodePlays"));
+TRACE_DECLARE_INT_COUNTER(AblePlayAnimation_DynamicMontagePlays, TEXT("Able/PlayAnimation/DynamicMontagePlays"));
+TRACE_DECLARE_INT_COUNTER(AblePlayAnimation_SingleNodeFallbacks, TEXT("Able/PlayAnimation/SingleNodeFallbacks"));
+TRACE_DECLARE_INT_COUNTER(AblePlayAnimation_FailedNodeLookups, TEXT("Able/PlayAnimation/FailedNodeLookups"));
+TRACE_DECLARE_INT_COUNTER(AblePlayAnimation_Targets, TEXT("Able/PlayAnimation/Targets"));
+
+/* Times a PlayAnimation branch on the stats system, the trace channel and the CSV profiler. */
+#define ABLE_PLAY_ANIMATION_SCOPE(Mode) \
+	SCOPE_CYCLE_COUNTER(STAT_AblePlayAnimation##Mode); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AblePlayAnimation_##Mode, AblePlayAnimationChannel); \
+	CSV_SCOPED_TIMING_STAT(AblePlayAnimation, Mode)
+
+/* Counts an event on the stats system, the trace counters and the CSV profiler. */
+#define ABLE_PLAY_ANIMATION_COUNT(Counter) \
+	INC_DWORD_STAT(STAT_AblePlayAnimation##Counter); \
+	TRACE_COUNTER_INCREMENT(AblePlayAnimation_##Counter); \
+	CSV_CUSTOM_STAT(AblePlayAnimation, Counter, 1, ECsvCustomStatOp::Accumulate)
+
+static TAutoConsoleVariable<bool> CVarAblePlayAnimationAllowSyncLoad(
+	TEXT("Able.PlayAnimation.AllowSyncLoad"),
+	true,
+	TEXT("If false, a Play Animation Task whose Animation was not preloaded requests an async load and starts late, once it arrives, instead of loading on the Game Thread."));
+
+static TAutoConsoleVariable<int32> CVarAblePlayAnimationDynamicMontageCacheSize(
+	TEXT("Able.PlayAnimation.DynamicMontageCacheSize"),
+	512,
+	TEXT("Maximum number of Dynamic Montages shared between Play Animation Tasks. 0 allocates a new Montage for every play."));
+
+static TAutoConsoleVariable<int32> CVarAblePlayAnimationTargetCacheSize(
+	TEXT("Able.PlayAnimation.TargetCacheSize"),
+	1024,
+	TEXT("Maximum number of Actors whose components Play Animation Tasks with Batch Targets keep between casts. 0 resolves them on every cast."));
+
+/* Stock Able collision Tasks read sockets without EvaluateServerPoseForLocation, so they would hit against a stale pose under Timeline Only. */
+static bool HasStockCollisionTask(const UAbleAbility& Ability)
+{
+	for (const UAbleAbilityTask* Task : Ability.GetTasks())
+	{
+		if (Task && (Task->IsA<UAbleCollisionQueryTask>() || Task->IsA<UAbleCollisionSweepTask>() || Task->IsA<UAbleRayCastQueryTask>()))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FAblePlayAnimationPreloadManifest::Gather(const UAbleAbility& Ability)
+{
+	Assets.Reset();
+	for (const UAbleAbilityTask* Task : Ability.GetTasks())
+	{
+		if (const UAblePlayAnimationTask* PlayAnimationTask = Cast<UAblePlayAnimationTask>(Task))
+		{
+			PlayAnimationTask->GatherPreloadAssets(Assets);
+		}
+	}
+}
+
+void FAblePlayAnimationPreloadManifest::RequestAsyncLoad()
+{
+	if (Assets.Num() == 0 || Handle.IsValid())
+	{
+		return;
+	}
+
+	Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Assets, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+}
+
+void FAblePlayAnimationPreloadManifest::Release()
+{
+	if (Handle.IsValid())
+	{
+		Handle->ReleaseHandle();
+		Handle.Reset();
+	}
+}
+
+bool FAblePlayAnimationPreloadManifest::IsLoaded() const
+{
+	return Assets.Num() == 0 || (Handle.IsValid() && Handle->HasLoadCompleted());
+}
+
+/* Dynamic Montages are immutable once created, so every cast with the same Sequence / Slot / Blend / Loop settings can share one instead of allocating a new Montage. */
+class FAbleDynamicMontageCache : public FGCObject
+{
+public:
+	static FAbleDynamicMontageCache& Get()
+	{
+		static FAbleDynamicMontageCache Instance;
+		return Instance;
+	}
+
+	UAnimMontage* FindOrCreate(const UAnimSequenceBase* Asset, const FName& SlotNodeName, float BlendInTime, float BlendOutTime, int32 LoopCount, float BlendOutTriggerTime)
+	{
+		const FKey Key{ FObjectKey(Asset), SlotNodeName, BlendInTime, BlendOutTime, LoopCount, BlendOutTriggerTime };
+		if (TObjectPtr<UAnimMontage>* CachedMontage = Montages.Find(Key))
+		{
+			INC_DWORD_STAT(STAT_AblePlayAnimationDynamicMontageCacheHits);
+			return *CachedMontage;
+		}
+
+		UAnimMontage* NewMontage = UAnimMontage::CreateSlotAnimationAsDynamicMontage(Asset, SlotNodeName, BlendInTime, BlendOutTime, 1.0f, LoopCount, BlendOutTriggerTime);
+		if (NewMontage)
+		{
+			INC_DWORD_STAT(STAT_AblePlayAnimationDynamicMontageAllocations);
+			if (Montages.Num() >= CVarAblePlayAnimationDynamicMontageCacheSize.GetValueOnGameThread())
+			{
+				Montages.Empty();
+			}
+			Montages.Add(Key, NewMontage);
+		}
+		return NewMontage;
+	}
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override
+	{
+		for (TPair<FKey, TObjectPtr<UAnimMontage>>& Entry : Montages)
+		{
+			Collector.AddReferencedObject(Entry.Value);
+		}
+	}
+
+	virtual FString GetReferencerName() const override
+	{
+		return TEXT("FAbleDynamicMontageCache");
+	}
+
+private:
+	FAbleDynamicMontageCache()
+	{
+		// Don't keep Sequences of the previous map resident.
+		FWorldDelegates::OnWorldCleanup.AddLambda([this](UWorld*, bool, bool)
+		{
+			Montages.Empty();
+		});
+	}
+
+	struct FKey
+	{
+		FObjectKey Sequence;
+		FName SlotNodeName;
+		float BlendInTime;
+		float BlendOutTime;
+		int32 LoopCount;
+		float BlendOutTriggerTime;
+
+		bool operator==(const FKey& Other) const
+		{
+			return Sequence == Other.Sequence && SlotNodeName == Other.SlotNodeName && BlendInTime == Other.BlendInTime && BlendOutTime == Other.BlendOutTime
+				&& LoopCount == Other.LoopCount && BlendOutTriggerTime == Other.BlendOutTriggerTime;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.Sequence), GetTypeHash(Key.SlotNodeName));
+			Hash = HashCombine(Hash, GetTypeHash(Key.BlendInTime));
+			Hash = HashCombine(Hash, GetTypeHash(Key.BlendOutTime));
+			Hash = HashCombine(Hash, GetTypeHash(Key.LoopCount));
+			return HashCombine(Hash, GetTypeHash(Key.BlendOutTriggerTime));
+		}
+	};
+
+	TMap<FKey, TObjectPtr<UAnimMontage>> Montages;
+};
+
+/* Components resolved for an Actor by a Batch Targets Task, kept between casts until one of them is gone. Only holds weak pointers, so it never keeps an Actor alive. */
+class FAblePlayAnimationTargetCache
+{
+public:
+	static FAblePlayAnimationTargetCache& Get()
+	{
+		static FAblePlayAnimationTargetCache Instance;
+		return Instance;
+	}
+
+	const FAblePlayAnimationTaskTarget* Find(const UAblePlayAnimationTask* Task, const AActor* Actor) const
+	{
+		const FAblePlayAnimationTaskTarget* Entry = Targets.Find(FKey{ FObjectKey(Task), FObjectKey(Actor) });
+		return Entry && IsStillValid(*Entry, Actor) ? Entry : nullptr;
+	}
+
+	void Add(const UAblePlayAnimationTask* Task, const AActor* Actor, const FAblePlayAnimationTaskTarget& Entry)
+	{
+		if (Targets.Num() >= CVarAblePlayAnimationTargetCacheSize.GetValueOnGameThread())
+		{
+			// Drop the Actors that are gone first, only start over if every entry is still in use.
+			for (TMap<FKey, FAblePlayAnimationTaskTarget>::TIterator It(Targets); It; ++It)
+			{
+				if (!It.Value().Actor.IsValid())
+				{
+					It.RemoveCurrent();
+				}
+			}
+
+			if (Targets.Num() >= CVarAblePlayAnimationTargetCacheSize.GetValueOnGameThread())
+			{
+				Targets.Empty();
+			}
+		}
+
+		if (CVarAblePlayAnimationTargetCacheSize.GetValueOnGameThread() > 0)
+		{
+			Targets.Add(FKey{ FObjectKey(Task), FObjectKey(Actor) }, Entry);
+		}
+	}
+
+private:
+	FAblePlayAnimationTargetCache()
+	{
+		FWorldDelegates::OnWorldCleanup.AddLambda([this](UWorld*, bool, bool)
+		{
+			Targets.Empty();
+		});
+	}
+
+	static bool IsStillValid(const FAblePlayAnimationTaskTarget& Entry, const AActor* Actor)
+	{
+		if (Entry.Actor.Get() != Actor)
+		{
+			return false;
+		}
+
+		for (const TWeakObjectPtr<USkeletalMeshComponent>& SkeletalComponent : Entry.SkeletalComponents)
+		{
+			if (!SkeletalComponent.IsValid() || SkeletalComponent->GetOwner() != Actor)
+			{
+				return false;
+			}
+		}
+
+		// A component we found before was destroyed, look again.
+		return !Entry.AbilityComponent.IsStale() && !Entry.PrimarySkeletalComponent.IsStale();
+	}
+
+	struct FKey
+	{
+		FObjectKey Task;
+		FObjectKey Actor;
+
+		bool operator==(const FKey& Other) const
+		{
+			return Task == Other.Task && Actor == Other.Actor;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.Task), GetTypeHash(Key.Actor));
+		}
+	};
+
+	TMap<FKey, FAblePlayAnimationTaskTarget> Targets;
+};
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand AblePlayAnimationBenchmarkDynamicMontageCacheCommand(
+	TEXT("Able.PlayAnimation.BenchmarkDynamicMontageCache"),
+	TEXT("Able.PlayAnimation.BenchmarkDynamicMontageCache [Casts=1000] [SequencePath]. Counts the UObjects Dynamic Montage casts allocate without and with the shared cache."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Casts = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+
+		const UAnimSequenceBase* Sequence = Args.Num() > 1 ? LoadObject<UAnimSequenceBase>(nullptr, *Args[1]) : nullptr;
+		for (TObjectIterator<UAnimSequence> It; It && !Sequence; ++It)
+		{
+			if (!It->HasAnyFlags(RF_ClassDefaultObject) && It->CanBeUsedInComposition())
+			{
+				Sequence = *It;
+			}
+		}
+
+		if (!Sequence)
+		{
+			UE_LOG(LogAbleSP, Warning, TEXT("Able.PlayAnimation.BenchmarkDynamicMontageCache Failed, no Animation Sequence is loaded !"));
+			return;
+		}
+
+		// Same Sequence / Slot / Blend every time, like one Ability cast over and over. No GC runs in between, so the object count only grows.
+		const FName SlotName(TEXT("DefaultSlot"));
+
+		const int32 UncachedObjectsStart = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		const double UncachedStart = FPlatformTime::Seconds();
+		for (int32 CastIndex = 0; CastIndex < Casts; ++CastIndex)
+		{
+			// What PlaySlotAnimationAsDynamicMontage allocates on every cast.
+			UAnimMontage::CreateSlotAnimationAsDynamicMontage(Sequence, SlotName, 0.25f, 0.25f, 1.0f, 1, -1.0f);
+		}
+		const double UncachedSeconds = FPlatformTime::Seconds() - UncachedStart;
+		const int32 UncachedObjects = GUObjectArray.GetObjectArrayNumMinusAvailable() - UncachedObjectsStart;
+
+		const int32 CachedObjectsStart = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		const double CachedStart = FPlatformTime::Seconds();
+		for (int32 CastIndex = 0; CastIndex < Casts; ++CastIndex)
+		{
+			FAbleDynamicMontageCache::Get().FindOrCreate(Sequence, SlotName, 0.25f, 0.25f, 1, -1.0f);
+		}
+		const double CachedSeconds = FPlatformTime::Seconds() - CachedStart;
+		const int32 CachedObjects = GUObjectArray.GetObjectArrayNumMinusAvailable() - CachedObjectsStart;
+
+		UE_LOG(LogAbleSP, Log, TEXT("Dynamic Montage cache, %d casts of %s: %d UObjects allocated without the cache (%.3f us per cast), %d with it (%.3f us per cast)."),
+			Casts, *Sequence->GetName(), UncachedObjects, UncachedSeconds * 1.0e6 / Casts, CachedObjects, CachedSeconds * 1.0e6 / Casts);
+	}));
+#endif
+
+/* The Ability Animation Player node only depends on the Anim Class, so we resolve it once per Class / State Machine / State. */
+struct FAbleAbilityAnimNodeKey
+{
+	FObjectKey AnimClass;
+	FName StateMachineName;
+	FName StateName;
+
+	bool operator==(const FAbleAbilityAnimNodeKey& Other) const
+	{
+		return AnimClass == Other.AnimClass && StateMachineName == Other.StateMachineName && StateName == Other.StateName;
+	}
+
+	friend uint32 GetTypeHash(const FAbleAbilityAnimNodeKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.AnimClass), GetTypeHash(Key.StateMachineName)), GetTypeHash(Key.StateName));
+	}
+};
+
+/* Node index of the Ability Animation Player node, INDEX_NONE if the Class doesn't have one. Game Thread only. */
+static TMap<FAbleAbilityAnimNodeKey, int32> GAbleAbilityAnimNodeIndexCache;
+
+static int32 FindAbilityAnimNodeIndex(UAnimInstance* Instance, const FName& StateMachineName, const FName& AbilityStateName)
+{
+	FAnimInstanceProxy InstanceProxy(Instance);
+
+	FAnimNode_StateMachine* StateMachineNode = InstanceProxy.GetStateMachineInstanceFromName(StateMachineName);
+	if (StateMachineNode)
+	{
+		const FBakedAnimationStateMachine* BakedStateMachine = InstanceProxy.GetMachineDescription(InstanceProxy.GetAnimClassInterface(), StateMachineNode);
+
+		if (BakedStateMachine)
+		{
+			for (const FBakedAnimationState& State : BakedStateMachine->States)
+			{
+				if (State.StateName == AbilityStateName)
+				{
+					for (const int32& PlayerNodeIndex : State.PlayerNodeIndices)
+					{
+						if (InstanceProxy.GetNodeFromIndexUntyped(PlayerNodeIndex, FAnimNode_SPAbilityAnimPlayer::StaticStruct()))
+						{
+							return PlayerNodeIndex;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+UAblePlayAnimationTaskScratchPad::UAblePlayAnimationTaskScratchPad()
+{
+
+}
+
+UAblePlayAnimationTaskScratchPad::~UAblePlayAnimationTaskScratchPad()
+{
+
+}
+
+void UAblePlayAnimationTaskScratchPad::SeekTrackedInstances(float TaskTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AblePlayAnimationSeek);
+
+	for (const FAblePlayAnimationMontageEntry& Entry : PlayingMontages)
+	{
+		if (UAnimInstance* AnimInstance = Entry.AnimInstance.Get())
+		{
+			if (FAnimMontageInstance* MontageInstance = AnimInstance->GetMontageInstanceForID(Entry.MontageInstanceID))
+			{
+				MontageInstance->SetPosition(Entry.StartPosition + TaskTime);
+			}
+		}
+	}
+
+	for (const TWeakObjectPtr<UAnimSingleNodeInstance>& SingleNode : SingleNodeInstances)
+	{
+		if (SingleNode.IsValid())
+		{
+			SingleNode->SetPosition(TaskTime);
+		}
+	}
+}
+
+void UAblePlayAnimationTaskScratchPad::SetTrackedPlayRate(float PlayRate)
+{
+	for (const FAblePlayAnimationMontageEntry& Entry : PlayingMontages)
+	{
+		if (UAnimInstance* AnimInstance = Entry.AnimInstance.Get())
+		{
+			if (FAnimMontageInstance* MontageInstance = AnimInstance->GetMontageInstanceForID(Entry.MontageInstanceID))
+			{
+				MontageInstance->SetPlayRate(PlayRate);
+			}
+		}
+	}
+
+	for (const TWeakObjectPtr<UAnimSingleNodeInstance>& SingleNode : SingleNodeInstances)
+	{
+		if (SingleNode.IsValid())
+		{
+			SingleNode->SetPlayRate(PlayRate);
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs AblePlayAnimationBenchmarkPlayRateCommand(
+	TEXT("Able.PlayAnimation.BenchmarkPlayRate"),
+	TEXT("Able.PlayAnimation.BenchmarkPlayRate [NumTargets=100] [Iterations=1000] [MontagePath]. Compares a play rate change through the tracked Montage instances with re-gathering the targets and meshes."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumTargets = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1000;
+
+		UAnimMontage* Montage = Args.Num() > 2 ? LoadObject<UAnimMontage>(nullptr, *Args[2]) : nullptr;
+		for (TObjectIterator<UAnimMontage> It; It && !Montage; ++It)
+		{
+			if (!It->HasAnyFlags(RF_ClassDefaultObject) && It->GetSkeleton())
+			{
+				Montage = *It;
+			}
+		}
+
+		// Any resident mesh of the Montage's Skeleton will do.
+		USkeletalMesh* Mesh = nullptr;
+		for (TObjectIterator<USkeletalMesh> It; It && Montage && !Mesh; ++It)
+		{
+			if (!It->HasAnyFlags(RF_ClassDefaultObject) && It->GetSkeleton() == Montage->GetSkeleton())
+			{
+				Mesh = *It;
+			}
+		}
+
+		if (!World || !Mesh)
+		{
+			UE_LOG(LogAbleSP, Warning, TEXT("Able.PlayAnimation.BenchmarkPlayRate Failed, no loaded Montage with a loaded Skeletal Mesh !"));
+			return;
+		}
+
+		UAblePlayAnimationTaskScratchPad* ScratchPad = NewObject<UAblePlayAnimationTaskScratchPad>(GetTransientPackage());
+		TArray<TWeakObjectPtr<AActor>> Targets;
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		for (int32 Index = 0; Index < NumTargets; ++Index)
+		{
+			ASkeletalMeshActor* Actor = World->SpawnActor<ASkeletalMeshActor>(ASkeletalMeshActor::StaticClass(), FTransform(FVector(Index * 200.0f, 0.0f, 0.0f)), SpawnParameters);
+			USkeletalMeshComponent* MeshComponent = Actor ? Actor->GetSkeletalMeshComponent() : nullptr;
+			if (!MeshComponent)
+			{
+				continue;
+			}
+
+			MeshComponent->SetSkeletalMesh(Mesh);
+			MeshComponent->SetAnimInstanceClass(UAnimInstance::StaticClass());
+			if (UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance())
+			{
+				AnimInstance->Montage_Play(Montage);
+				if (const FAnimMontageInstance* MontageInstance = AnimInstance->GetActiveInstanceForMontage(Montage))
+				{
+					FAblePlayAnimationMontageEntry& Entry = ScratchPad->PlayingMontages.AddDefaulted_GetRef();
+					Entry.AnimInstance = AnimInstance;
+					Entry.Montage = Montage;
+					Entry.MontageInstanceID = MontageInstance->GetInstanceID();
+				}
+			}
+			Targets.Add(Actor);
+		}
+
+		// What a play rate change used to do: gather the targets, find their meshes, check which Montage is playing.
+		const UAnimationAsset* AnimationAsset = Montage;
+		const double GatherStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const float PlayRate = 1.0f + (Iteration & 1) * 0.5f;
+			TArray<TWeakObjectPtr<AActor>> TargetArray = Targets;
+			for (const TWeakObjectPtr<AActor>& Target : TargetArray)
+			{
+				TInlineComponentArray<USkeletalMeshComponent*> SkeletalComponents(Target.Get());
+				for (USkeletalMeshComponent* SkeletalComponent : SkeletalComponents)
+				{
+					UAnimInstance* AnimInstance = SkeletalComponent->GetAnimInstance();
+					const UAnimMontage* PlayingMontage = Cast<UAnimMontage>(AnimationAsset);
+					if (AnimInstance && PlayingMontage && AnimInstance->GetCurrentActiveMontage() == PlayingMontage)
+					{
+						AnimInstance->Montage_SetPlayRate(PlayingMontage, PlayRate);
+					}
+				}
+			}
+		}
+		const double GatherSeconds = FPlatformTime::Seconds() - GatherStart;
+
+		const double TrackedStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			ScratchPad->SetTrackedPlayRate(1.0f + (Iteration & 1) * 0.5f);
+		}
+		const double TrackedSeconds = FPlatformTime::Seconds() - TrackedStart;
+
+		UE_LOG(LogAbleSP, Log, TEXT("Play Animation play rate change, %d targets (%d tracked Montages) x %d iterations: tracked %.3f us, re-gather %.3f us (per change)."),
+			Targets.Num(), ScratchPad->PlayingMontages.Num(), Iterations, TrackedSeconds * 1.0e6 / Iterations, GatherSeconds * 1.0e6 / Iterations);
+
+		for (const TWeakObjectPtr<AActor>& Target : Targets)
+		{
+			if (AActor* Actor = Target.Get())
+			{
+				Actor->Destroy();
+			}
+		}
+	}));
+#endif
+
+UAblePlayAnimationTask::UAblePlayAnimationTask(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer),
+	m_AnimationAsset(nullptr),
+	m_AnimationMontageSection(NAME_None),
+	m_OnEndAnimationMontageSection(NAME_None),
+	m_AnimationMode(EAblePlayAnimationTaskAnimMode::DynamicMontage),
+	m_StateMachineName(),
+	m_AbilityStateName(),
+	m_Loop(false),
+	m_SlotName(TEXT("DefaultSlot")),
+	m_TimeToStartMontageAt(0.0f),
+	m_BlendOutTriggerTime(-1.0f),
+	m_NumberOfLoops(1),
+	m_StopAllMontages(false),
+	m_PlayRate(1.0f),
+	m_ScaleWithAbilityPlayRate(true),
+	m_StopAnimationOnInterrupt(true),
+	m_ClearQueuedAnimationOnInterrupt(false),
+	m_ResetAnimationStateOnEnd(false),
+	m_ManuallySpecifyAnimationLength(false),
+	m_ManualLengthIsInterrupt(true),
+	m_EventName(NAME_None),
+	m_PlayOnServer(false),
+	m_ServerAnimationMode(EAblePlayAnimationServerMode::ServerFullPose),
+	m_OverrideVisibilityBasedAnimTick(false),
+	m_VisibilityBasedAnimTickPriority(0),
+	m_BatchTargets(false),
+	m_BakedAnimationLength(-1.0f),
+	m_BakedAnimationSection(NAME_None)
+{
+
+}
+
+UAblePlayAnimationTask::~UAblePlayAnimationTask()
+{
+
+}
+
+FString UAblePlayAnimationTask::GetModuleName_Implementation() const
+{
+	return TEXT("Feature.StarP.Script.System.Ability.Task.AblePlayAnimationTask");
+}
+
+void UAblePlayAnimationTask::OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
+{
+	Super::OnTaskStart(Context);
+	OnTaskStartBP(Context.Get());
+}
+
+void UAblePlayAnimationTask::OnTaskStartBP_Implementation(const UAbleAbilityContext* Context) const
+{
+
+	const UAnimationAsset* AnimationAsset = GetAnimationAsset();
+
+	if (!AnimationAsset && !m_AnimationAsset.IsNull())
+	{
+		RequestAnimationLoad(Context);
+		return;
+	}
+
+	if (!AnimationAsset)
+	{
+		UE_LOG(LogAbleSP, Warning, TEXT("No Animation set for PlayAnimationTask in Ability [%s]"), *Context->GetAbility()->GetAbilityName());
+		return;
+	}
+
+	TArray<TWeakObjectPtr<AActor>> TargetArray;
+	GetActorsForTask(Context, TargetArray);
+
+	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
+	ScratchPad->AbilityComponents.Empty();
+	ScratchPad->SingleNodeSkeletalComponents.Empty();
+	ScratchPad->PlayingMontages.Reset();
+	ScratchPad->SingleNodeInstances.Reset();
+	ReleaseAnimTickOverrides(Context, *ScratchPad);
+	ScratchPad->Targets.Reset(TargetArray.Num());
+
+	// Montages can be advanced without evaluating the pose, everything else needs the full Anim Graph.
+	const bool bUsesMontage = m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage || (m_AnimationMode == EAblePlayAnimationTaskAnimMode::SingleNode && AnimationAsset->IsA<UAnimMontage>());
+	const bool bServerTimelineOnly = bUsesMontage && m_PlayOnServer && m_ServerAnimationMode == EAblePlayAnimationServerMode::ServerTimelineOnly && UKismetSystemLibrary::IsDedicatedServer(this)
+		&& !HasStockCollisionTask(*Context->GetAbility());
+
+	float BasePlayRate = m_PlayRate;
+	float PlayRate = BasePlayRate * (m_ScaleWithAbilityPlayRate ? Context->GetAbility()->GetPlayRate(Context) : 1.0f);
+	FName MontageSection = m_AnimationMontageSection;
+
+#if STATS
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+#endif
+
+	if (m_BatchTargets)
+	{
+		// Resolve the components of every Actor (or reuse the ones of an earlier cast), then play on all of them in a single pass.
+		{
+			SCOPE_CYCLE_COUNTER(STAT_AblePlayAnimationResolveTargets);
+
+			FAblePlayAnimationTargetCache& TargetCache = FAblePlayAnimationTargetCache::Get();
+			for (TWeakObjectPtr<AActor>& Target : TargetArray)
+			{
+				if (Target.IsValid())
+				{
+					if (const FAblePlayAnimationTaskTarget* CachedEntry = TargetCache.Find(this, Target.Get()))
+					{
+						INC_DWORD_STAT(STAT_AblePlayAnimationTargetCacheHits);
+						ScratchPad->Targets.Add(*CachedEntry);
+					}
+					else
+					{
+						FAblePlayAnimationTaskTarget& Entry = ScratchPad->Targets.AddDefaulted_GetRef();
+						ResolveTarget(Context, *Target, Entry);
+						TargetCache.Add(this, Target.Get(), Entry);
+					}
+				}
+			}
+		}
+
+		{
+			SCOPE_CYCLE_COUNTER(STAT_AblePlayAnimationPlayTargets);
+
+			for (const FAblePlayAnimationTaskTarget& Entry : ScratchPad->Targets)
+			{
+				PlayTarget(Context, AnimationAsset, MontageSection, *ScratchPad, Entry, PlayRate, bServerTimelineOnly);
+			}
+		}
+	}
+	else
+	{
+		for (TWeakObjectPtr<AActor>& Target : TargetArray)
+		{
+			if (Target.IsValid())
+			{
+				FAblePlayAnimationTaskTarget& Entry = ScratchPad->Targets.AddDefaulted_GetRef();
+				ResolveTarget(Context, *Target, Entry);
+				PlayTarget(Context, AnimationAsset, MontageSection, *ScratchPad, Entry, PlayRate, bServerTimelineOnly);
+			}
+		}
+	}
+
+	TRACE_COUNTER_ADD(AblePlayAnimation_Targets, ScratchPad->Targets.Num());
+	CSV_CUSTOM_STAT(AblePlayAnimation, Targets, ScratchPad->Targets.Num(), ECsvCustomStatOp::Accumulate);
+
+#if STATS
+	INC_DWORD_STAT_BY(STAT_AblePlayAnimationTargets, ScratchPad->Targets.Num());
+	if (ScratchPad->Targets.Num() > 0)
+	{
+		SET_FLOAT_STAT(STAT_AblePlayAnimationPerTargetMs, FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) / ScratchPad->Targets.Num());
+	}
+#endif
+}
+
+void UAblePlayAnimationTask::ResolveTarget(const UAbleAbilityContext* Context, AActor& TargetActor, FAblePlayAnimationTaskTarget& Entry) const
+{
+	Entry.Actor = &TargetActor;
+
+	if (USkeletalMeshComponent* PreferredComponent = Context->GetAbility()->GetSkeletalMeshComponentForActor(Context, &TargetActor, m_EventName))
+	{
+		Entry.SkeletalComponents.Add(PreferredComponent);
+	}
+	else
+	{
+		TInlineComponentArray<USkeletalMeshComponent*> InSkeletalComponents(&TargetActor);
+		Entry.SkeletalComponents.Append(InSkeletalComponents);
+	}
+
+	if (m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode)
+	{
+		Entry.AbilityComponent = TargetActor.FindComponentByClass<UAbleAbilityComponent>();
+	}
+
+	if (m_OverrideVisibilityBasedAnimTick)
+	{
+		Entry.PrimarySkeletalComponent = TargetActor.FindComponentByClass<USkeletalMeshComponent>();
+	}
+}
+
+void UAblePlayAnimationTask::PlayTarget(const UAbleAbilityContext* Context, const UAnimationAsset* AnimationAsset, const FName& MontageSection, UAblePlayAnimationTaskScratchPad& ScratchPad, const FAblePlayAnimationTaskTarget& Entry, float PlayRate, bool bServerTimelineOnly) const
+{
+	for (const TWeakObjectPtr<USkeletalMeshComponent>& SkeletalComponent : Entry.SkeletalComponents)
+	{
+		// Montage_Play callbacks of earlier targets can destroy Actors and components, so check again before every play.
+		AActor* TargetActor = Entry.Actor.Get();
+		USkeletalMeshComponent* SkeletalMeshComponent = SkeletalComponent.Get();
+		if (!TargetActor || !SkeletalMeshComponent)
+		{
+			continue;
+		}
+
+		PlayAnimation(Context, AnimationAsset, MontageSection, *TargetActor, ScratchPad, *SkeletalMeshComponent, Entry.AbilityComponent.Get(), PlayRate);
+
+		if (bServerTimelineOnly && SkeletalComponent.IsValid())
+		{
+			// Only tick the Montage (sections, notifies, root motion), the pose is evaluated on demand by EvaluateServerPose.
+			PushAnimTickOverride(Context, ScratchPad, *SkeletalMeshComponent, EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered);
+		}
+	}
+
+	if (m_OverrideVisibilityBasedAnimTick && !bServerTimelineOnly)
+	{
+		if (USkeletalMeshComponent* TargetMesh = Entry.PrimarySkeletalComponent.Get())
+		{
+			PushAnimTickOverride(Context, ScratchPad, *TargetMesh, m_VisibilityBasedAnimTick);
+		}
+	}
+}
+
+void UAblePlayAnimationTask::RequestAnimationLoad(const UAbleAbilityContext* Context) const
+{
+	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (ScratchPad->PendingLoadHandle.IsValid())
+	{
+		return;
+	}
+
+	UE_LOG(LogAbleSP, Verbose, TEXT("PlayAnimationTask delaying %s until it is loaded, sync loads are disabled."), *m_AnimationAsset.ToString());
+
+	const TWeakObjectPtr<const UAblePlayAnimationTask> WeakTask(this);
+	const TWeakObjectPtr<const UAbleAbilityContext> WeakContext(Context);
+	const TWeakObjectPtr<UAblePlayAnimationTaskScratchPad> WeakScratchPad(ScratchPad);
+	ScratchPad->PendingLoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(m_AnimationAsset.ToSoftObjectPath(), FStreamableDelegate::CreateLambda([WeakTask, WeakContext, WeakScratchPad]()
+	{
+		// OnTaskEnd cancels the load, so a valid handle means the cast is still running.
+		const UAblePlayAnimationTask* Task = WeakTask.Get();
+		const UAbleAbilityContext* LoadContext = WeakContext.Get();
+		UAblePlayAnimationTaskScratchPad* LoadScratchPad = WeakScratchPad.Get();
+		if (!Task || !LoadContext || !LoadScratchPad || !LoadScratchPad->PendingLoadHandle.IsValid())
+		{
+			return;
+		}
+
+		// Our start plays the Animation now that it is resident; it stays resident while it plays.
+		const TSharedPtr<FStreamableHandle> Handle = MoveTemp(LoadScratchPad->PendingLoadHandle);
+		Task->OnTaskStartBP(LoadContext);
+		LoadScratchPad->SeekTrackedInstances(LoadContext->GetCurrentTime() - Task->GetStartTime());
+		Handle->ReleaseHandle();
+	}), FStreamableManager::AsyncLoadHighPriority);
+}
+
+void UAblePlayAnimationTask::OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const EAbleAbilityTaskResult result) const
+{
+	Super::OnTaskEnd(Context, result);
+
+	// A cast that ends before its Animation arrived never plays it.
+	if (UAblePlayAnimationTaskScratchPad* ScratchPad = Context.IsValid() ? Cast<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this)) : nullptr)
+	{
+		if (ScratchPad->PendingLoadHandle.IsValid())
+		{
+			ScratchPad->PendingLoadHandle->CancelHandle();
+			ScratchPad->PendingLoadHandle.Reset();
+		}
+	}
+
+	OnTaskEndBP(Context.Get(), result);
+}
+
+void UAblePlayAnimationTask::OnTaskEndBP_Implementation(const UAbleAbilityContext* Context, const EAbleAbilityTaskResult result) const
+{
+
+	if (!Context)
+	{
+		return;
+	}
+
+	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (!ScratchPad) return;
+	
+	// Reset any Single Node instances that were previous AnimBlueprint mode.
+	for (TWeakObjectPtr<USkeletalMeshComponent>& SkeletalComponent : ScratchPad->SingleNodeSkeletalComponents)
+	{
+		if(SkeletalComponent == nullptr)
+			continue;
+		if (m_ResetAnimationStateOnEnd)
+		{
+			SkeletalComponent->SetAnimationMode(EAnimationMode::AnimationBlueprint);
+		}
+
+		// If we're in Animation Node mode, and our Ability was interrupted - tell the Animation Node.
+		if (m_StopAnimationOnInterrupt && (
+			(result == EAbleAbilityTaskResult::Interrupted || (result == EAbleAbilityTaskResult::BranchSegment && bStopAnimationOnBranch) || result == EAbleAbilityTaskResult::StopAcross) ||
+			(m_ManuallySpecifyAnimationLength && m_ManualLengthIsInterrupt) ) )
+		{
+			switch (m_AnimationMode)
+			{
+			case EAblePlayAnimationTaskAnimMode::AbilityAnimationNode:
+			{
+				if (FAnimNode_SPAbilityAnimPlayer* AnimPlayer = GetAbilityAnimGraphNode(Context, SkeletalComponent.Get()))
+				{
+					AnimPlayer->OnAbilityInterrupted(m_ClearQueuedAnimationOnInterrupt);
+				}
+			}
+			break;
+			case EAblePlayAnimationTaskAnimMode::DynamicMontage:
+			{
+				if (UAnimInstance* Instance = SkeletalComponent->GetAnimInstance())
+				{
+					FName MontageOnEnd = m_OnEndAnimationMontageSection;
+					if (MontageOnEnd != NAME_None)
+					{
+						Instance->Montage_JumpToSection(MontageOnEnd);
+					}
+					else
+					{
+						Instance->Montage_Stop(m_DynamicMontageBlend.m_BlendOut);
+					}
+				}
+			}
+			break;
+			case EAblePlayAnimationTaskAnimMode::SingleNode:
+			{
+				SkeletalComponent->SetAnimationMode(EAnimationMode::AnimationBlueprint);
+				if (UAnimSingleNodeInstance* SingleNode = SkeletalComponent->GetSingleNodeInstance())
+				{
+					SingleNode->StopAnim();
+				}
+			}
+			break;
+			default:
+				checkNoEntry();
+				break;
+			}
+
+		}
+	}
+
+	ReleaseAnimTickOverrides(Context, *ScratchPad);
+}
+
+void UAblePlayAnimationTask::PushAnimTickOverride(const UAbleAbilityContext* Context, UAblePlayAnimationTaskScratchPad& ScratchPad, USkeletalMeshComponent& MeshComponent, EVisibilityBasedAnimTickOption Option) const
+{
+	UAbleAnimTickOverrideSubsystem* TickOverrides = MeshComponent.GetWorld() ? MeshComponent.GetWorld()->GetSubsystem<UAbleAnimTickOverrideSubsystem>() : nullptr;
+	if (!TickOverrides)
+	{
+		return;
+	}
+
+	const int32 Handle = TickOverrides->PushOverride(&MeshComponent, Option, m_VisibilityBasedAnimTickPriority);
+	if (Handle == INDEX_NONE)
+	{
+		return;
+	}
+
+	FAblePlayAnimationTickOverride& TickOverride = ScratchPad.AnimTickOverrides.AddDefaulted_GetRef();
+	TickOverride.Handle = Handle;
+	TickOverride.Mesh = &MeshComponent;
+	if (UKismetSystemLibrary::IsDedicatedServer(this))
+	{
+		UAbleAbilityBlueprintLibrary::SetComponentTickEnableImplicitRef(TEXT("DynamicSetAnimationTickable"), &MeshComponent, Context);
+	}
+}
+
+void UAblePlayAnimationTask::ReleaseAnimTickOverrides(const UAbleAbilityContext* Context, UAblePlayAnimationTaskScratchPad& ScratchPad) const
+{
+	if (ScratchPad.AnimTickOverrides.Num() == 0)
+	{
+		return;
+	}
+
+	// Pop by handle even if the mesh is gone, otherwise the subsystem keeps counting it against the server budget.
+	const UWorld* World = Context ? Context->GetWorld() : nullptr;
+	UAbleAnimTickOverrideSubsystem* TickOverrides = World ? World->GetSubsystem<UAbleAnimTickOverrideSubsystem>() : nullptr;
+
+	for (const FAblePlayAnimationTickOverride& TickOverride : ScratchPad.AnimTickOverrides)
+	{
+		USkeletalMeshComponent* MeshComponent = TickOverride.Mesh.Get();
+		if (!TickOverrides && MeshComponent && MeshComponent->GetWorld())
+		{
+			TickOverrides = MeshComponent->GetWorld()->GetSubsystem<UAbleAnimTickOverrideSubsystem>();
+		}
+
+		if (TickOverrides)
+		{
+			TickOverrides->PopOverride(TickOverride.Handle);
+		}
+
+		if (MeshComponent)
+		{
+			if (UKismetSystemLibrary::IsDedicatedServer(this))
+			{
+				UAbleAbilityBlueprintLibrary::SetComponentTickDisableImplicitRef(TEXT("DynamicSetAnimationTickable"), MeshComponent, Context);
+			}
+		}
+	}
+	ScratchPad.AnimTickOverrides.Empty();
+}
+
+
+bool UAblePlayAnimationTask::IsDone(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const
+{
+	return Super::IsDone(Context);
+}
+
+bool UAblePlayAnimationTask::IsDoneBP_Implementation(const UAbleAbilityContext* Context) const
+{
+	float PlayRate = m_PlayRate;
+	return Context->GetCurrentTime() * PlayRate > GetEndTime();
+}
+
+float UAblePlayAnimationTask::GetEndTime() const
+{
+	if (m_ManuallySpecifyAnimationLength)
+	{
+		return Super::GetEndTime();
+	}
+	float AnimationLength = m_BakedAnimationLength;
+	if (!HasBakedAnimationLength())
+	{
+		// The length is part of the timeline, so an unbaked Task loads the Animation even when sync loads are disabled. Resave the Ability to bake it.
+		const UAnimationAsset* AnimationAsset = m_AnimationAsset.Get();
+		if (!AnimationAsset && !m_AnimationAsset.IsNull())
+		{
+			ABLE_PLAY_ANIMATION_COUNT(SyncLoads);
+			AnimationAsset = m_AnimationAsset.LoadSynchronous();
+		}
+		AnimationLength = CalculateAnimationLength(AnimationAsset);
+	}
+	float PlayRate = m_PlayRate; // Assume a flat playrate. 
+
+	// fallback
+	float endTime = GetStartTime() + 1.0f;
+	if (AnimationLength >= 0.0f)
+	{
+		endTime = GetStartTime() + (AnimationLength * (1.0f / PlayRate));
+	}
+	return m_Loop ? FMath::Max(Super::GetEndTime(), endTime) : endTime;
+}
+
+float UAblePlayAnimationTask::CalculateAnimationLength(const UAnimationAsset* AnimationAsset) const
+{
+	if (const UAnimMontage* Montage = Cast<UAnimMontage>(AnimationAsset))
+	{
+		if (m_AnimationMontageSection != NAME_None)
+		{
+			int32 sectionIndex = Montage->GetSectionIndex(m_AnimationMontageSection);
+			if (sectionIndex != INDEX_NONE)
+			{
+				return Montage->GetSectionLength(sectionIndex);
+			}
+		}
+
+		return const_cast<UAnimMontage*>(Montage)->GetPlayLength();
+	}
+	else if (const UAnimSequenceBase* Sequence = Cast<UAnimSequenceBase>(AnimationAsset))
+	{
+		return const_cast<UAnimSequenceBase*>(Sequence)->GetPlayLength();
+	}
+
+	return -1.0f;
+}
+
+bool UAblePlayAnimationTask::HasBakedAnimationLength() const
+{
+	return m_BakedAnimationLength >= 0.0f && m_BakedAnimationSection == m_AnimationMontageSection && m_BakedAnimationPath == m_AnimationAsset.ToSoftObjectPath();
+}
+
+void UAblePlayAnimationTask::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	m_BakedAnimationPath = m_AnimationAsset.ToSoftObjectPath();
+	m_BakedAnimationSection = m_AnimationMontageSection;
+	m_BakedAnimationLength = m_AnimationAsset.IsNull() ? -1.0f : CalculateAnimationLength(m_AnimationAsset.LoadSynchronous());
+
+	// The Section can be overridden at runtime, so bake all of them.
+	m_BakedSectionStartTimes.Reset();
+	if (const UAnimMontage* Montage = Cast<UAnimMontage>(m_AnimationAsset.Get()))
+	{
+		for (const FCompositeSection& Section : Montage->CompositeSections)
+		{
+			m_BakedSectionStartTimes.Add(Section.SectionName, Section.GetTime());
+		}
+	}
+}
+
+float UAblePlayAnimationTask::GetSectionStartTime(const UAnimMontage& Montage, const FName& Section) const
+{
+	// Pointer check first, the path comparison is only between existing paths (no string building).
+	if (m_AnimationAsset.Get() == &Montage && m_BakedAnimationPath == m_AnimationAsset.ToSoftObjectPath())
+	{
+		if (const float* StartTime = m_BakedSectionStartTimes.Find(Section))
+		{
+			return *StartTime;
+		}
+	}
+
+	const int32 SectionIndex = Montage.GetSectionIndex(Section);
+	return Montage.IsValidSectionIndex(SectionIndex) ? Montage.CompositeSections[SectionIndex].GetTime() : 0.0f;
+}
+
+UAbleAbilityTaskScratchPad* UAblePlayAnimationTask::CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const
+{
+	if (UAbleAbilityUtilitySubsystem* Subsystem = Context->GetUtilitySubsystem())
+	{
+		static TSubclassOf<UAbleAbilityTaskScratchPad> ScratchPadClass = UAblePlayAnimationTaskScratchPad::StaticClass();
+		return Subsystem->FindOrConstructTaskScratchPad(ScratchPadClass);
+	}
+
+	return NewObject<UAblePlayAnimationTaskScratchPad>(Context.Get());
+}
+
+TStatId UAblePlayAnimationTask::GetStatId() const
+{
+	 RETURN_QUICK_DECLARE_CYCLE_STAT(UAblePlayAnimationTask, STATGROUP_Able);
+}
+
+void UAblePlayAnimationTask::SetAnimationAsset(UAnimationAsset* Animation)
+{
+	check(Animation->IsA<UAnimSequenceBase>() || Animation->IsA<UAnimMontage>());
+	m_AnimationAsset = Animation;
+}
+
+void UAblePlayAnimationTask::EvaluateServerPose(USkeletalMeshComponent* MeshComponent)
+{
+	// Timeline Only meshes are never rendered on the server, so the pose is only as fresh as the last time someone asked for it.
+	if (MeshComponent && !MeshComponent->bRecentlyRendered && MeshComponent->VisibilityBasedAnimTickOption == EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered)
+	{
+		// Every query of a frame reads the same pose, so only the first one evaluates it.
+		static uint64 EvaluatedFrame = 0;
+		static TSet<FObjectKey> EvaluatedMeshes;
+		if (EvaluatedFrame != GFrameCounter)
+		{
+			EvaluatedFrame = GFrameCounter;
+			EvaluatedMeshes.Reset();
+		}
+
+		bool bAlreadyEvaluated = false;
+		EvaluatedMeshes.Add(FObjectKey(MeshComponent), &bAlreadyEvaluated);
+		if (bAlreadyEvaluated)
+		{
+			return;
+		}
+
+		SCOPE_CYCLE_COUNTER(STAT_AblePlayAnimationEvaluateServerPose);
+		MeshComponent->RefreshBoneTransforms();
+	}
+}
+
+void UAblePlayAnimationTask::EvaluateServerPoseForLocation(const UAbleAbilityContext* Context, const FAbleAbilityTargetTypeLocation& Location)
+{
+	// Only socket Locations read bones, and only dedicated servers run Timeline Only.
+	if (!Context || Location.GetSocketName() == NAME_None || !UKismetSystemLibrary::IsDedicatedServer(Context))
+	{
+		return;
+	}
+
+	const auto EvaluateActor = [](AActor* Actor)
+	{
+		if (Actor)
+		{
+			TInlineComponentArray<USkeletalMeshComponent*> SkeletalComponents(Actor);
+			for (USkeletalMeshComponent* SkeletalComponent : SkeletalComponents)
+			{
+				EvaluateServerPose(SkeletalComponent);
+			}
+		}
+	};
+
+	switch (Location.GetSourceTargetType())
+	{
+	case EAbleAbilityTargetType::ATT_Self:
+		EvaluateActor(Context->GetSelfActor());
+		break;
+	case EAbleAbilityTargetType::ATT_Owner:
+		EvaluateActor(Context->GetOwner());
+		break;
+	case EAbleAbilityTargetType::ATT_Instigator:
+		EvaluateActor(Context->GetInstigator());
+		break;
+	case EAbleAbilityTargetType::ATT_TargetActor:
+		for (const TWeakObjectPtr<AActor>& Target : Context->GetTargetActorsWeakPtr())
+		{
+			EvaluateActor(Target.Get());
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+namespace AblePlayAnimationServerPose
+{
+	/* Compares the pose Timeline Only gives a mesh with the pose a full Anim Graph update gives it at the same Montage position. */
+	static void CompareMesh(USkeletalMeshComponent& MeshComponent, double& OutMaxError, double& OutTotalError, int64& OutNumBones)
+	{
+		UAnimInstance* AnimInstance = MeshComponent.GetAnimInstance();
+		if (!AnimInstance || !AnimInstance->IsAnyMontagePlaying() || MeshComponent.bRecentlyRendered)
+		{
+			return;
+		}
+
+		UAblePlayAnimationTask::EvaluateServerPose(&MeshComponent);
+		const TArray<FTransform> TimelinePose = MeshComponent.GetComponentSpaceTransforms();
+
+		// A zero delta update refreshes the graph (slot weights, blends) without moving the Montages.
+		AnimInstance->UpdateAnimation(0.0f, false);
+		MeshComponent.RefreshBoneTransforms();
+		const TArray<FTransform>& FullPose = MeshComponent.GetComponentSpaceTransforms();
+
+		for (int32 BoneIndex = 0; BoneIndex < FMath::Min(TimelinePose.Num(), FullPose.Num()); ++BoneIndex)
+		{
+			const double Error = FVector::Dist(TimelinePose[BoneIndex].GetLocation(), FullPose[BoneIndex].GetLocation());
+			OutMaxError = FMath::Max(OutMaxError, Error);
+			OutTotalError += Error;
+			++OutNumBones;
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs AblePlayAnimationCompareServerPoseCommand(
+	TEXT("Able.PlayAnimation.CompareServerPose"),
+	TEXT("Able.PlayAnimation.CompareServerPose [NumFrames=300] [-Quit]. On a dedicated server, compares every frame the bones Timeline Only meshes evaluate on demand with a full Anim Graph update at the same Montage position. Runs headless, e.g. -ExecCmds=\"Able.PlayAnimation.CompareServerPose 300 -Quit\"."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		TArray<FString> Values = Args;
+		const bool bQuit = Values.RemoveAll([](const FString& Arg) { return Arg.Equals(TEXT("-Quit"), ESearchCase::IgnoreCase); }) > 0;
+		const int32 NumFrames = Values.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Values[0])) : 300;
+
+		int32 Frame = 0;
+		int32 NumMeshes = 0;
+		int64 NumBones = 0;
+		double MaxError = 0.0;
+		double TotalError = 0.0;
+		TWeakObjectPtr<UWorld> WeakWorld = World;
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([=](float DeltaTime) mutable
+		{
+			if (WeakWorld.IsValid() && Frame < NumFrames)
+			{
+				for (TObjectIterator<USkeletalMeshComponent> It; It; ++It)
+				{
+					if (It->GetWorld() == WeakWorld.Get() && It->VisibilityBasedAnimTickOption == EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered)
+					{
+						const int64 PreviousNumBones = NumBones;
+						AblePlayAnimationServerPose::CompareMesh(**It, MaxError, TotalError, NumBones);
+						NumMeshes += NumBones > PreviousNumBones ? 1 : 0;
+					}
+				}
+
+				++Frame;
+				return true;
+			}
+
+			UE_LOG(LogAbleSP, Log, TEXT("Able.PlayAnimation.CompareServerPose %d frames, %d mesh samples: max bone error %.4f cm, mean %.4f cm."),
+				Frame, NumMeshes, MaxError, NumBones > 0 ? TotalError / NumBones : 0.0);
+
+			if (bQuit)
+			{
+				FPlatformMisc::RequestExit(false);
+			}
+			return false;
+		}));
+	}));
+#endif
+
+const UAnimationAsset* UAblePlayAnimationTask::GetAnimationAsset() const
+{
+	if (const UAnimationAsset* AnimationAsset = m_AnimationAsset.Get())
+	{
+		return AnimationAsset;
+	}
+
+	if (m_AnimationAsset.IsNull())
+	{
+		return nullptr;
+	}
+
+	// Not resident, so the owning Ability was not preloaded (see UAblePlayAnimationPreloadSubsystem).
+	// Without sync loads the caller streams it in for the cast, see RequestAnimationLoad.
+	if (!CVarAblePlayAnimationAllowSyncLoad.GetValueOnAnyThread())
+	{
+		return nullptr;
+	}
+
+	ABLE_PLAY_ANIMATION_COUNT(SyncLoads);
+	UE_LOG(LogAbleSP, Verbose, TEXT("PlayAnimationTask synchronously loading %s."), *m_AnimationAsset.ToString());
+	return m_AnimationAsset.LoadSynchronous();
+}
+
+void UAblePlayAnimationTask::GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	if (!m_AnimationAsset.IsNull())
+	{
+		OutAssets.AddUnique(m_AnimationAsset.ToSoftObjectPath());
+	}
+}
+
+void UAblePlayAnimationTask::OnAbilityPlayRateChanged(const UAbleAbilityContext* Context, float NewPlayRate)
+{
+	Super::OnAbilityPlayRateChanged(Context, NewPlayRate);
+	if (!Context)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_AblePlayAnimationPlayRateChanged);
+
+	UAblePlayAnimationTaskScratchPad* ScratchPad = Cast<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (!ScratchPad)
+	{
+		return;
+	}
+
+	ScratchPad->SetTrackedPlayRate(NewPlayRate);
+}
+
+void UAblePlayAnimationTask::PlayAnimation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const UAnimationAsset* AnimationAsset, const FName& MontageSection, AActor& TargetActor, UAblePlayAnimationTaskScratchPad& ScratchPad, USkeletalMeshComponent& SkeletalMeshComponent, UAbleAbilityComponent* AbilityComponent, float PlayRate) const
+{
+	switch (m_AnimationMode.GetValue())
+	{
+		case EAblePlayAnimationTaskAnimMode::SingleNode:
+		{
+			ABLE_PLAY_ANIMATION_SCOPE(SingleNode);
+			ABLE_PLAY_ANIMATION_COUNT(SingleNodePlays);
+
+			// Make a note of these so we can reset to Animation Blueprint mode.
+			if (SkeletalMeshComponent.GetAnimationMode() == EAnimationMode::AnimationBlueprint)
+			{
+				ScratchPad.SingleNodeSkeletalComponents.Add(&SkeletalMeshComponent);
+			}
+
+			if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(AnimationAsset))
+			{
+				if (UAnimInstance* Instance = SkeletalMeshComponent.GetAnimInstance())
+				{
+#if !(UE_BUILD_SHIPPING)
+					if (IsVerbose())
+					{
+						PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Montage %s (Section %s) on Target %s"), 
+                            *MontageAsset->GetName(), *MontageSection.ToString(), *TargetActor.GetName()));
+					}
+#endif
+					float StartMontageAt = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_TimeToStartMontageAt);
+
+					ScratchPad.CurrentAnimMontage = const_cast<UAnimMontage*>(MontageAsset);
+					Instance->Montage_Play(ScratchPad.CurrentAnimMontage.Get(), PlayRate, EMontagePlayReturnType::MontageLength, StartMontageAt, ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StopAllMontages));
+					TrackMontage(ScratchPad, *Instance, ScratchPad.CurrentAnimMontage.Get(), MontageSection != NAME_None ? GetSectionStartTime(*MontageAsset, MontageSection) : 0.0f);
+
+                    if (MontageSection != NAME_None)
+                    {
+#if !(UE_BUILD_SHIPPING)
+                        if (!MontageAsset->IsValidSectionName(MontageSection))
+                        {
+                            PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Montage %s (Section %s) on Target %s Invalid Montage Section"),
+                                *MontageAsset->GetName(), *MontageSection.ToString(), *TargetActor.GetName()));
+                        }
+#endif
+
+                        Instance->Montage_JumpToSection(MontageSection, MontageAsset);
+                    }
+				}
+			}
+			else if (UAnimSingleNodeInstance* SingleNode = SkeletalMeshComponent.GetSingleNodeInstance()) // See if we already have an instance instantiated.
+			{
+#if !(UE_BUILD_SHIPPING)
+				if (IsVerbose())
+				{
+					PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Animation %s on Target %s"), *AnimationAsset->GetName(), *TargetActor.GetName()));
+				}
+#endif
+				SingleNode->SetAnimationAsset(const_cast<UAnimationAsset*>(AnimationAsset), m_Loop, PlayRate);
+				SingleNode->PlayAnim(m_Loop);
+				ScratchPad.SingleNodeInstances.Add(SingleNode);
+			}
+			else // Nope, start a new one.
+			{
+#if !(UE_BUILD_SHIPPING)
+				if (IsVerbose())
+				{
+					PrintVerbose(Context, FString::Printf(TEXT("Playing Single Node Animation %s on Target %s"), *AnimationAsset->GetName(), *TargetActor.GetName()));
+				}
+#endif
+				SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationSingleNode);
+				SkeletalMeshComponent.SetAnimation(const_cast<UAnimationAsset*>(AnimationAsset));
+				SkeletalMeshComponent.SetPlayRate(PlayRate);
+				SkeletalMeshComponent.Play(m_Loop);
+				ScratchPad.SingleNodeInstances.Add(SkeletalMeshComponent.GetSingleNodeInstance());
+			}
+		}
+		break;
+		case EAblePlayAnimationTaskAnimMode::AbilityAnimationNode:
+		{
+			ABLE_PLAY_ANIMATION_SCOPE(AbilityAnimationNode);
+			ABLE_PLAY_ANIMATION_COUNT(AbilityAnimationNodePlays);
+
+			if (SkeletalMeshComponent.GetAnimationMode() != EAnimationMode::AnimationBlueprint)
+			{
+				SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationBlueprint);
+			}
+			
+			if (UAnimInstance* Instance = SkeletalMeshComponent.GetAnimInstance())
+			{
+				const UWorld* World= GetWorld();
+				if (World && World->IsGameWorld())
+				{
+					const UAnimSequence* AnimationSequence = Cast<UAnimSequence>(AnimationAsset);
+					if (AnimationSequence)
+					{
+						if (FAnimNode_SPAbilityAnimPlayer* AbilityPlayerNode = GetAbilityAnimGraphNode(Context, &SkeletalMeshComponent))
+						{
+#if !(UE_BUILD_SHIPPING)
+							if (IsVerbose())
+							{
+								PrintVerbose(Context, FString::Printf(TEXT("Playing Animation %s on Target %s using Ability Animation Node"), *AnimationAsset->GetName(), *TargetActor.GetName()));
+							}
+#endif
+							AbilityPlayerNode->PlayAnimationSequence(AnimationSequence, PlayRate, m_BlendIn, m_BlendOut);
+
+							if (AbilityComponent)
+							{
+								ScratchPad.AbilityComponents.Add(AbilityComponent);
+
+								AbilityComponent->SetAbilityAnimationNode(AbilityPlayerNode);
+							}
+						}
+						else
+						{
+							ABLE_PLAY_ANIMATION_COUNT(FailedNodeLookups);
+							UE_LOG(LogAbleSP, Warning, TEXT("Failed to find Ability Animation Node using State Machine Name %s and Node Name %s"), *m_StateMachineName.ToString(), *m_AbilityStateName.ToString());
+						}
+					}
+					else
+					{
+						UE_LOG(LogAbleSP, Warning, TEXT("Ability Animation Node only supports Animation Sequences. Unable to play %s"), *AnimationAsset->GetName());
+					}
+				}
+				else
+				{
+					// Use play animation single node instead since no matter what, this timing is just for preview.
+					ABLE_PLAY_ANIMATION_COUNT(SingleNodeFallbacks);
+					SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationSingleNode);
+					SkeletalMeshComponent.SetAnimation(const_cast<UAnimationAsset*>(AnimationAsset));
+					SkeletalMeshComponent.SetPlayRate(PlayRate);
+					SkeletalMeshComponent.Play(m_Loop);
+				}
+			}
+		}
+		break;
+		case EAblePlayAnimationTaskAnimMode::DynamicMontage:
+		{
+			ABLE_PLAY_ANIMATION_SCOPE(DynamicMontage);
+			ABLE_PLAY_ANIMATION_COUNT(DynamicMontagePlays);
+
+			if (SkeletalMeshComponent.GetAnimationMode() != EAnimationMode::AnimationBlueprint)
+			{
+				SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationBlueprint);
+			}
+
+			if (UAnimInstance* Instance = SkeletalMeshComponent.GetAnimInstance())
+			{
+				float StartMontageAt = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_TimeToStartMontageAt);
+				float BlendOutTimeAt = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_BlendOutTriggerTime);
+				int32 NumLoops = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_NumberOfLoops);
+				FName SlotName = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_SlotName);
+
+				if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(AnimationAsset))
+				{
+#if !(UE_BUILD_SHIPPING)
+					if (IsVerbose())
+					{
+						PrintVerbose(Context, FString::Printf(TEXT("Playing Montage Animation %s on Target %s using Dynamic Montage"), *MontageAsset->GetName(), *TargetActor.GetName()));
+					}
+#endif
+					ScratchPad.CurrentAnimMontage = const_cast<UAnimMontage*>(MontageAsset);
+					Instance->Montage_Play(ScratchPad.CurrentAnimMontage.Get(), PlayRate, EMontagePlayReturnType::MontageLength, StartMontageAt, ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StopAllMontages));
+					TrackMontage(ScratchPad, *Instance, ScratchPad.CurrentAnimMontage.Get(), StartMontageAt);
+				}
+				else if (const UAnimSequenceBase* SequenceAsset = Cast<UAnimSequenceBase>(AnimationAsset))
+				{
+#if !(UE_BUILD_SHIPPING)
+					if (IsVerbose())
+					{
+						PrintVerbose(Context, FString::Printf(TEXT("Playing Slot Animation %s on Target %s on Slot %s using Dynamic Montage"), *SequenceAsset->GetName(), *TargetActor.GetName(), *SlotName.ToString()));
+					}
+#endif
+					
+					const UWorld* World= GetWorld();
+					if (World && World->IsGameWorld())
+					{
+						//loop次数默认值为1
+						if (m_Loop && NumLoops <= 1)
+						{
+							//使用蒙太奇播放不会使用m_Loop，需要使用loop次数才能保持loop，动画会在TaskEnd结束时结束
+							NumLoops = INT_MAX;
+						}
+						const FAbleBlendTimes DynamicMontageBlend = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_DynamicMontageBlend);
+						ScratchPad.CurrentAnimMontage = PlayMontageBySequence(Instance, const_cast<UAnimSequenceBase*>(SequenceAsset), SlotName, DynamicMontageBlend.m_BlendIn, DynamicMontageBlend.m_BlendOut, PlayRate, NumLoops, BlendOutTimeAt, StartMontageAt, ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StopAllMontages));
+						TrackMontage(ScratchPad, *Instance, ScratchPad.CurrentAnimMontage.Get(), StartMontageAt);
+						// ScratchPad.CurrentAnimMontage = Instance->PlaySlotAnimationAsDynamicMontage(const_cast<UAnimSequenceBase*>(SequenceAsset), SlotName, DynamicMontageBlend.m_BlendIn, DynamicMontageBlend.m_BlendOut, PlayRate, NumLoops, BlendOutTimeAt, StartMontageAt);
+					}
+					else
+					{
+						// Use play animation single node instead since PlaySlotAnimationAsDynamicMontage() does not play animation in editor preview.
+						ABLE_PLAY_ANIMATION_COUNT(SingleNodeFallbacks);
+						SkeletalMeshComponent.SetAnimationMode(EAnimationMode::AnimationSingleNode);
+						SkeletalMeshComponent.SetAnimation(const_cast<UAnimationAsset*>(AnimationAsset));
+						SkeletalMeshComponent.SetPlayRate(PlayRate);
+						SkeletalMeshComponent.Play(m_Loop);
+						ScratchPad.SingleNodeInstances.Add(SkeletalMeshComponent.GetSingleNodeInstance());
+					}
+				}
+			}
+		}
+		break;
+		default:
+		{
+			checkNoEntry();
+		}
+		break;
+	}
+
+	if (m_StopAnimationOnInterrupt)
+	{
+		ScratchPad.SingleNodeSkeletalComponents.Add(&SkeletalMeshComponent);
+	}
+}
+
+void UAblePlayAnimationTask::TrackMontage(UAblePlayAnimationTaskScratchPad& ScratchPad, UAnimInstance& AnimInstance, UAnimMontage* Montage, float StartPosition)
+{
+	if (const FAnimMontageInstance* MontageInstance = Montage ? AnimInstance.GetActiveInstanceForMontage(Montage) : nullptr)
+	{
+		FAblePlayAnimationMontageEntry& Entry = ScratchPad.PlayingMontages.AddDefaulted_GetRef();
+		Entry.AnimInstance = &AnimInstance;
+		Entry.Montage = Montage;
+		Entry.MontageInstanceID = MontageInstance->GetInstanceID();
+		Entry.StartPosition = StartPosition;
+	}
+}
+
+UAnimMontage* UAblePlayAnimationTask::PlayMontageBySequence(UAnimInstance* Instance, UAnimSequenceBase* Asset, FName SlotNodeName,
+	float BlendInTime, float BlendOutTime, float InPlayRate, int32 LoopCount, float BlendOutTriggerTime,
+	float InTimeToStartMontageAt, bool bStopAllMontages, float Weight) const
+{
+	if (Asset && Instance)
+	{
+		if (CVarAblePlayAnimationDynamicMontageCacheSize.GetValueOnGameThread() <= 0 || !Asset->CanBeUsedInComposition())
+		{
+			INC_DWORD_STAT(STAT_AblePlayAnimationDynamicMontageAllocations);
+			return Instance->PlaySlotAnimationAsDynamicMontage(Asset, SlotNodeName, BlendInTime, BlendOutTime, InPlayRate, LoopCount, BlendOutTriggerTime, InTimeToStartMontageAt);
+		}
+
+		if (UAnimMontage* Montage = FAbleDynamicMontageCache::Get().FindOrCreate(Asset, SlotNodeName, BlendInTime, BlendOutTime, LoopCount, BlendOutTriggerTime))
+		{
+			// Same as PlaySlotAnimationAsDynamicMontage, which always stops the other Montages of the group.
+			const float PlayLength = Instance->Montage_Play(Montage, InPlayRate, EMontagePlayReturnType::MontageLength, InTimeToStartMontageAt);
+			return PlayLength > 0.0f ? Montage : nullptr;
+		}
+	}
+	return nullptr;
+}
+
+FAnimNode_SPAbilityAnimPlayer* UAblePlayAnimationTask::GetAbilityAnimGraphNode(const TWeakObjectPtr<const UAbleAbilityContext>& Context, USkeletalMeshComponent* MeshComponent) const
+{
+	if (UAnimInstance* Instance = MeshComponent->GetAnimInstance())
+	{
+		FName StateMachineName = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_StateMachineName);
+		FName AbilityStateName = ABL_GET_DYNAMIC_PROPERTY_VALUE(Context, m_AbilityStateName);
+
+		const FAbleAbilityAnimNodeKey Key{ FObjectKey(Instance->GetClass()), StateMachineName, AbilityStateName };
+		const int32* CachedNodeIndex = GAbleAbilityAnimNodeIndexCache.Find(Key);
+		if (!CachedNodeIndex)
+		{
+#if WITH_EDITOR
+			static FDelegateHandle ObjectsReplacedHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddLambda([](const TMap<UObject*, UObject*>&)
+			{
+				// Anim Blueprint recompiles can reorder the node properties of a class.
+				GAbleAbilityAnimNodeIndexCache.Empty();
+			});
+#endif
+			CachedNodeIndex = &GAbleAbilityAnimNodeIndexCache.Add(Key, FindAbilityAnimNodeIndex(Instance, StateMachineName, AbilityStateName));
+		}
+
+		if (*CachedNodeIndex != INDEX_NONE)
+		{
+			// Same lookup as FAnimInstanceProxy::GetNodeFromIndexUntyped, without building a proxy.
+			if (IAnimClassInterface* AnimClassInterface = IAnimClassInterface::GetFromClass(Instance->GetClass()))
+			{
+				const TArray<FStructProperty*>& AnimNodeProperties = AnimClassInterface->GetAnimNodeProperties();
+				const int32 PropertyIndex = AnimNodeProperties.Num() - 1 - *CachedNodeIndex;
+				if (AnimNodeProperties.IsValidIndex(PropertyIndex) && AnimNodeProperties[PropertyIndex]->Struct->IsChildOf(FAnimNode_SPAbilityAnimPlayer::StaticStruct()))
+				{
+					return AnimNodeProperties[PropertyIndex]->ContainerPtrToValuePtr<FAnimNode_SPAbilityAnimPlayer>(Instance);
+				}
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+void UAblePlayAnimationTask::OnAbilityTimeSet(const TWeakObjectPtr<const UAbleAbilityContext>& Context)
+{
+	UAblePlayAnimationTaskScratchPad* ScratchPad = CastChecked<UAblePlayAnimationTaskScratchPad>(Context->GetScratchPadForTask(this));
+	if (!ScratchPad) return;
+
+	const float TaskTime = Context->GetCurrentTime() - GetStartTime();
+	if (m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode)
+	{
+		// Reset any Single Node instances that were previous AnimBlueprint mode.
+		for (TWeakObjectPtr<USkeletalMeshComponent>& SkeletalComponent : ScratchPad->SingleNodeSkeletalComponents)
+		{
+			if (FAnimNode_SPAbilityAnimPlayer* AbilityNode = GetAbilityAnimGraphNode(Context, SkeletalComponent.Get()))
+			{
+				AbilityNode->SetAnimationTime(TaskTime);
+			}
+		}
+	}
+
+	// Dynamic Montages keep playing from where they are when the Ability time is set.
+	if (m_AnimationMode != EAblePlayAnimationTaskAnimMode::DynamicMontage)
+	{
+		ScratchPad->SeekTrackedInstances(TaskTime);
+	}
+}
+
+void UAblePlayAnimationTask::BindDynamicDelegates(UAbleAbility* Ability)
+{
+	Super::BindDynamicDelegates(Ability);
+
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_AnimationAsset, TEXT("Animation"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_DynamicMontageBlend, TEXT("Play Blend"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_PlayRate, TEXT("Play Rate"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_TimeToStartMontageAt, TEXT("Time To Start At"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_BlendOutTriggerTime, TEXT("Blend Out Trigger Time"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_NumberOfLoops, TEXT("Number Of Loops"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_StopAllMontages, TEXT("Stop All Montages"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_SlotName, TEXT("Slot Name"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_StateMachineName, TEXT("State Machine Name"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_AbilityStateName, TEXT("Ability State Name"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_AnimationMontageSection, TEXT("Montage Section"));
+	ABL_BIND_DYNAMIC_PROPERTY(Ability, m_OnEndAnimationMontageSection, TEXT("Montage Section on End"));
+}
+
+#if WITH_EDITOR
+
+FText UAblePlayAnimationTask::GetDescriptiveTaskName() const
+{
+	const FText FormatText = LOCTEXT("AblePlayAnimationTaskFormat", "{0}: {1}");
+	FString AnimationName = TEXT("<null>");
+	const UAnimationAsset* AnimationAsset = m_AnimationAsset.LoadSynchronous();
+	if (AnimationAsset)
+	{
+        AnimationName = m_AnimationAsset->GetName();
+
+        if (const UAnimMontage* MontageAsset = Cast<UAnimMontage>(AnimationAsset))
+        {
+            if (m_AnimationMontageSection != NAME_None)
+            {
+                if(MontageAsset->IsValidSectionName(m_AnimationMontageSection))
+                    AnimationName = FString::Format(TEXT("{0}({1})"), { m_AnimationAsset->GetName(), m_AnimationMontageSection.ToString() });
+                else
+                    AnimationName = FString::Format(TEXT("{0}({1})"), { m_AnimationAsset->GetName(), TEXT("<InvalidSection>") });
+            }
+        }
+	}
+	else if (m_AnimationAssetDelegate.IsBound())
+	{
+		AnimationName = TEXT("Dynamic");
+	}
+
+	return FText::FormatOrdered(FormatText, GetTaskName(), FText::FromString(AnimationName));
+}
+
+FText UAblePlayAnimationTask::GetRichTextTaskSummary() const
+{
+	FTextBuilder StringBuilder;
+
+	StringBuilder.AppendLine(Super::GetRichTextTaskSummary());
+
+	FString AnimationName = TEXT("NULL");
+	if (m_AnimationAssetDelegate.IsBound())
+	{
+		AnimationName = FString::Format(TEXT("<a id=\"AbleTextDecorators.GraphReference\" style=\"RichText.Hyperlink\" GraphName=\"{0}\">Dynamic</>"), { m_AnimationAssetDelegate.GetFunctionName().ToString() });
+	}
+	else
+	{
+		AnimationName = FString::Format(TEXT("<a id=\"AbleTextDecorators.AssetReference\" style=\"RichText.Hyperlink\" PropertyName=\"m_AnimationAsset\" Filter=\"AnimationAsset\">{0}</>"), { !m_AnimationAsset.ToString().IsEmpty() ? m_AnimationAsset.ToString() : AnimationName });
+	}
+	StringBuilder.AppendLineFormat(LOCTEXT("AblePlayAnimationTaskRichFmt", "\t- Animation: {0}"), FText::FromString(AnimationName));
+
+	return StringBuilder.ToText();
+}
+
+EDataValidationResult UAblePlayAnimationTask::IsTaskDataValid(const UAbleAbility* AbilityContext, const FText& AssetName, TArray<FText>& ValidationErrors)
+{
+    EDataValidationResult result = EDataValidationResult::Valid;
+
+    // Make sure the baked length still matches the asset (e.g. the Montage was edited after this Ability was saved).
+    if (m_BakedAnimationLength >= 0.0f && !m_AnimationAsset.IsNull())
+    {
+        const float LiveLength = CalculateAnimationLength(m_AnimationAsset.LoadSynchronous());
+        if (!HasBakedAnimationLength() || !FMath::IsNearlyEqual(LiveLength, m_BakedAnimationLength))
+        {
+            ValidationErrors.Add(FText::Format(LOCTEXT("AblePlayAnimationTaskStaleLength", "Baked animation length {0} of {1} does not match the asset ({2}), resave the Ability: {3}"), FText::AsNumber(m_BakedAnimationLength), FText::FromString(m_AnimationAsset.ToString()), FText::AsNumber(LiveLength), AssetName));
+            result = EDataValidationResult::Invalid;
+        }
+    }
+
+    if (m_PlayOnServer && m_ServerAnimationMode == EAblePlayAnimationServerMode::ServerTimelineOnly && AbilityContext && HasStockCollisionTask(*AbilityContext))
+    {
+        ValidationErrors.Add(FText::Format(LOCTEXT("AblePlayAnimationTaskTimelineOnlyCollision", "Server Animation Mode Timeline Only can't be used with Collision Query, Collision Sweep or Raycast Tasks, they read sockets from a stale pose. Use Full Pose: {0}"), AssetName));
+        result = EDataValidationResult::Invalid;
+    }
+
+    return result;
+}
+
+#endif
+
+EAbleAbilityTaskRealm UAblePlayAnimationTask::GetTaskRealmBP_Implementation() const { return m_PlayOnServer ? EAbleAbilityTaskRealm::ATR_ClientAndServer : EAbleAbilityTaskRealm::ATR_Client; }
+
+#undef ABLE_PLAY_ANIMATION_SCOPE
+#undef ABLE_PLAY_ANIMATION_COUNT
+#undef LOCTEXT_NAMESPACE
+
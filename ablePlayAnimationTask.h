@@ -1,341 +1,528 @@
-﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
-
-#pragma once
-
-#include "UnLuaInterface.h"
-#include "ableAbilityTypes.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "IAbleAbilityTask.h"
-#include "UObject/ObjectMacros.h"
-
-#include "ablePlayAnimationTask.generated.h"
-
-#define LOCTEXT_NAMESPACE "AbleAbilityTask"
-
-class UAnimationAsset;
-class UAbleAbilityComponent;
-class UAbleAbilityContext;
-
-/* Scratchpad for our Task. */
-UCLASS(Transient)
-class ABLECORESP_API UAblePlayAnimationTaskScratchPad : public UAbleAbilityTaskScratchPad
-{
-	GENERATED_BODY()
-public:
-	UAblePlayAnimationTaskScratchPad();
-	virtual ~UAblePlayAnimationTaskScratchPad();
-
-	/* The Ability Components of all the actors we affected. */
-	UPROPERTY(transient)
-	TArray<TWeakObjectPtr<UAbleAbilityComponent>> AbilityComponents;
-
-	/* The Skeletal Mesh Components of all the actors we affected (Single Node only). */
-	UPROPERTY(transient)
-	TArray<TWeakObjectPtr<USkeletalMeshComponent>> SingleNodeSkeletalComponents;
-
-	UPROPERTY(transient)
-	TMap<TWeakObjectPtr<USkeletalMeshComponent>,EVisibilityBasedAnimTickOption> CachedVisibilityBasedAnimTickOptionMap;
-
-	UPROPERTY()
-	TWeakObjectPtr<UAnimMontage> CurrentAnimMontage;
-};
-
-UENUM(BlueprintType)
-enum EAblePlayAnimationTaskAnimMode
-{
-	SingleNode UMETA(DisplayName="Single Node"),
-	AbilityAnimationNode UMETA(DisplayName = "Ability Animation Node"),
-	DynamicMontage UMETA(DisplayName = "Dynamic Montage")
-};
-
-UCLASS()
-class ABLECORESP_API UAblePlayAnimationTask : public UAbleAbilityTask, public IUnLuaInterface
-{
-	GENERATED_BODY()
-
-protected:
-	virtual FString GetModuleName_Implementation() const override;
-
-public:
-	UAblePlayAnimationTask(const FObjectInitializer& ObjectInitializer);
-	virtual ~UAblePlayAnimationTask();
-
-	/* Start our Task. */
-	virtual void OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskStart"))
-	void OnTaskStartBP(const UAbleAbilityContext* Context) const;
-	
-	/* End our Task. */
-	virtual void OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const EAbleAbilityTaskResult result) const override;
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskEnd"))
-	void OnTaskEndBP(const UAbleAbilityContext* Context, const EAbleAbilityTaskResult result) const;
-
-	/* Check if our Task is finished. */
-	virtual bool IsDone(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "IsDone"))
-	bool IsDoneBP(const UAbleAbilityContext* Context) const;
-
-	/* Returns the End time of our Task. */
-	virtual float GetEndTime() const override;
-
-	/* Returns which realm this Task belongs to. */
-	virtual EAbleAbilityTaskRealm GetTaskRealm() const override { return GetTaskRealmBP(); }
-
-	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "GetTaskRealm"))
-	EAbleAbilityTaskRealm GetTaskRealmBP() const;
-
-	/* Creates the Scratchpad for our Task. */
-	virtual UAbleAbilityTaskScratchPad* CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const;
-
-	/* Returns the Profiler Stat ID for our Task. */
-	virtual TStatId GetStatId() const override;
-
-	/* Called when our Time has been set. */
-	virtual void OnAbilityTimeSet(const TWeakObjectPtr<const UAbleAbilityContext>& Context) override;
-
-	/* Setup Dynamic Binding. */
-	virtual void BindDynamicDelegates( UAbleAbility* Ability ) override;
-
-#if WITH_EDITOR
-	/* Returns the category of our Task. */
-	virtual FText GetTaskCategory() const override { return LOCTEXT("AblePlayAnimationTaskCategory", "Animation"); }
-	
-	/* Returns the name of our Task. */
-	virtual FText GetTaskName() const override { return LOCTEXT("AblePlayAnimationTask", "Play Animation"); }
-
-	/* Returns the dynamic, descriptive name of our Task. */
-	virtual FText GetDescriptiveTaskName() const override;
-	
-	/* Returns the Rich Text description, with mark ups. */
-	virtual FText GetRichTextTaskSummary() const override;
-
-	/* Returns the description of our Task. */
-	virtual FText GetTaskDescription() const override { return LOCTEXT("AblePlayAnimationTaskDesc", "Plays an Animation asset (currently only Animation Montage and Animation Segments are supported)."); }
-	
-	/* Returns the color of our Task. */
-	virtual FLinearColor GetTaskColor() const override { return FLinearColor(177.0f / 255.0f, 44.0f / 255.0f, 87.0f / 255.0f); } // Light Blue
-	
-	/* Returns the estimated runtime cost of our Task. */
-	virtual float GetEstimatedTaskCost() const override { return ABLETASK_EST_SYNC; }
-
-	/* Returns how to display the End time of our Task. */
-	virtual EVisibility ShowEndTime() const override { return m_ManuallySpecifyAnimationLength ? EVisibility::Visible : EVisibility::Hidden; } // Hidden = Read only (it's still using space in the layout, so might as well display it).
-
-    EDataValidationResult IsTaskDataValid(const UAbleAbility* AbilityContext, const FText& AssetName, TArray<FText>& ValidationErrors) override;
-#endif
-	/* Returns the Animation Asset. */
-	FORCEINLINE const UAnimationAsset* GetAnimationAsset() const { return m_AnimationAsset.LoadSynchronous(); }
-
-	FORCEINLINE TSoftObjectPtr<UAnimationAsset> GetSoftAnimationAsset() const { return m_AnimationAsset; }
-	
-    /* Returns the Ability State Name. */
-    FORCEINLINE const FName& GetAnimationMontageSectionName() const { return m_AnimationMontageSection; }
-
-	/* Sets the Animation Asset. */
-	void SetAnimationAsset(UAnimationAsset* Animation);
-
-	/* Returns the Animation Mode. */
-	FORCEINLINE EAblePlayAnimationTaskAnimMode GetAnimationMode() const { return m_AnimationMode.GetValue(); }
-	
-	/* Returns the State Machine Name. */
-	FORCEINLINE const FName& GetStateMachineName() const { return m_StateMachineName; }
-	
-	/* Returns the Ability State Name. */
-	FORCEINLINE const FName& GetAbilityStateName() const { return m_AbilityStateName; }
-
-	/* Sets animation mode. */
-	FORCEINLINE void SetAnimationMode(EAblePlayAnimationTaskAnimMode Mode) { m_AnimationMode = Mode; }
-
-	/* Sets is loop. */
-	FORCEINLINE void SetLoop(bool Loop) { m_Loop = Loop; }
-
-	/* Sets is reset animation state on end. */
-	FORCEINLINE void SetResetAnimationStateOnEnd(bool Reset) { m_ResetAnimationStateOnEnd = Reset; }
-
-	/* Sets dynamic montage blend. */
-	FORCEINLINE void SetDynamicMontageBlend(const FAbleBlendTimes& BlendTimes) { m_DynamicMontageBlend = BlendTimes; }
-
-	/* Sets slot name. */
-	FORCEINLINE void SetSlotName(const FName& SlotName) { m_SlotName = SlotName; }
-
-	/* Sets time to start montage at. */
-	FORCEINLINE void SetTimeToStartMontageAt(float Time) { m_TimeToStartMontageAt = Time; }
-
-	/* Sets blend out trigger time. */
-	FORCEINLINE void SetBlendOutTriggerTime(float Time) { m_BlendOutTriggerTime = Time; }
-
-	/* Sets number of loops. */
-	FORCEINLINE void SetNumberOfLoops(int32 Loops) { m_NumberOfLoops = Loops; }
-
-	/* Sets stop all montages. */
-	FORCEINLINE void SetStopAllMontages(bool Stop) { m_StopAllMontages = Stop; }
-
-	virtual void OnAbilityPlayRateChanged(const UAbleAbilityContext* Context, float NewPlayRate) override;
-
-protected:
-	/* Helper method to clean up code a bit. This method does the actual PlayAnimation/Montage_Play/etc call.*/
-	void PlayAnimation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const UAnimationAsset* AnimationAsset, const FName& MontageSection, AActor& TargetActor, UAblePlayAnimationTaskScratchPad& ScratchPad, USkeletalMeshComponent& SkeletalMeshComponent, float PlayRate) const;
-
-	void SetAnimationPlayRateInRunTime(const UAbleAbilityContext* Context, const USkeletalMeshComponent& MeshComp, float NewPlayRate) const;
-	
-	virtual UAnimMontage* PlayMontageBySequence(UAnimInstance* Instance, UAnimSequenceBase* Asset, FName SlotNodeName, float BlendInTime = 0.25f, float BlendOutTime = 0.25f, float InPlayRate = 1.f, int32 LoopCount = 1, float BlendOutTriggerTime = -1.f, float InTimeToStartMontageAt = 0.f, bool bStopAllMontages = true, float Weight = 1.0f) const;
-	
-	/* Helper method to find the AbilityAnimGraph Node, if it exists. */
-	struct FAnimNode_SPAbilityAnimPlayer* GetAbilityAnimGraphNode(const TWeakObjectPtr<const UAbleAbilityContext>& Context, USkeletalMeshComponent* MeshComponent) const;
-	
-	// The Animation to play.
-    UPROPERTY(EditAnywhere, Category="Animation", meta = (DisplayName = "Animation", AbleBindableProperty, AbleDefaultBinding = "OnGetAnimationAssetBP", AllowedClasses = "AnimMontage,AnimSequence"))
-	TSoftObjectPtr<UAnimationAsset> m_AnimationAsset;
-
-	UPROPERTY()
-	FGetAbleAnimation m_AnimationAssetDelegate;
-
-	/* The animation montage section to jump to if using Dynamic Montages. */
-    UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Montage Section", AbleBindableProperty))
-    FName m_AnimationMontageSection;
-
-	UPROPERTY()
-	FGetAbleName m_AnimationMontageSectionDelegate;
-
-	/* If set, Jump to this montage section when the Task ends, if using Dynamic Montages. Set it to Name_None to disable this feature.*/
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Montage Section on End", AbleBindableProperty ))
-	FName m_OnEndAnimationMontageSection;
-
-	UPROPERTY()
-	FGetAbleName m_OnEndAnimationMontageSectionDelegate;
-
-	/* What mode to use for this task. 
-	*  Single Node - Plays the Animation as a Single Node Animation outside of the Animation Blueprint (if there is one).
-	*  Ability Animation Node - Plays the Animation using the Ability Animation Node within an Animation State Machine.
-	*  Dynamic Montage - Plays the Animation as a Dynamic Montage.
-	*/
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Animation Mode", EditCondition = "m_AnimationAsset!=nullptr"))
-	TEnumAsByte<EAblePlayAnimationTaskAnimMode> m_AnimationMode;
-
-	/* The name of the State Machine we should look for our Ability State in.*/
-	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "State Machine Name", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
-	FName m_StateMachineName;
-
-	UPROPERTY()
-	FGetAbleName m_StateMachineNameDelegate;
-
-	/* The name of the State that contains the Ability Animation Player Node*/
-	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "Ability State Name", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
-	FName m_AbilityStateName;
-
-	UPROPERTY()
-	FGetAbleName m_AbilityStateNameDelegate;
-
-	/* If the node is already playing an animation, this is the blend used transition to this animation.*/
-	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "Blend In", EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
-	FAlphaBlend m_BlendIn;
-
-	/* If the node doesn't have any more animations to play, this is the blend used transition out of this animation. NOTE: Currently unused.*/
-	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "Blend Out", EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
-	FAlphaBlend m_BlendOut;
-
-	// Whether or not to loop the animation.
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Loop", EditCondition="m_AnimationAsset!=nullptr"))
-	bool m_Loop;
-
-	// Blend times to use when playing the animation as a dynamic montage.
-	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Play Blend", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
-	FAbleBlendTimes m_DynamicMontageBlend;
-
-	UPROPERTY()
-	FGetAbleBlendTimes m_DynamicMontageBlendDelegate;
-
-	// Slot Name to use for the Sequence when playing as a dynamic montage.
-	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Slot Name", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
-	FName m_SlotName;
-
-	UPROPERTY()
-	FGetAbleName m_SlotNameDelegate;
-
-	// Used when attempting to play a Slot Animation Asset as a Dynamic Montage, or playing a Montage Asset (including as a Single Node Animation). Offsets the starting time of the animation.
-	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Time To Start At", AbleBindableProperty, EditCondition = "m_AnimationMode != EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
-	float m_TimeToStartMontageAt;
-
-	UPROPERTY()
-	FGetAbleFloat m_TimeToStartMontageAtDelegate;
-
-	// Used when attempting to play a Slot Animation Asset as a Dynamic Montage. Offsets the Blend out time. 
-	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Blend Out Trigger Time", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
-	float m_BlendOutTriggerTime;
-
-	UPROPERTY()
-	FGetAbleFloat m_BlendOutTriggerTimeDelegate;
-
-	// Used when attempting to play a Slot Animation Asset as a Dynamic Montage. Loops the Animation N times.
-	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Number Of Loops", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
-	int32 m_NumberOfLoops;
-
-	UPROPERTY()
-	FGetAbleInt m_NumberOfLoopsDelegate;
-
-	// Used when attempting to play a Montage Asset (including as a Single Node Animation). Stops all existing montages.
-	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Stop All Montages", AbleBindableProperty, EditCondition = "m_AnimationMode != EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
-	bool m_StopAllMontages;
-
-	UPROPERTY()
-	FGetAbleBool m_StopAllMontagesDelegate;
-
-	// Animation Play Rate
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Play Rate", AbleBindableProperty, EditCondition = "m_AnimationAsset!=nullptr"))
-	float m_PlayRate;
-
-	UPROPERTY()
-	FGetAbleFloat m_PlayRateDelegate;
-
-	// If true, we scale our Animation Play Rate by what our Ability Play Rate is. So, if your Ability Play Rate is 2.0, the animation play rate is multiplied by that same value.
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Scale With Ability Play Rate", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool m_ScaleWithAbilityPlayRate;
-
-	// If true, stop the current playing animation mid blend if the owning Ability is interrupted. Only applies when Animation Mode is set to Ability Animation Node.
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Stop on Interrupt", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool m_StopAnimationOnInterrupt;
-
-	// If true, any queued up (using the Ability Animation Node) animations will be removed as well. 
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Clear Queued Animation On Interrupt", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool m_ClearQueuedAnimationOnInterrupt;
-
-	// If true, Able will try to reset you into whatever Animation State you were in when the Task started (e.g., Single Instance vs Animation Blueprint).
-	// You can disable this if you see it causing issues, as this does reset the animation instance time when it's called.
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Reset Animation State On End", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool m_ResetAnimationStateOnEnd;
-
-	// If true, you can tell Able how long this task (and thus the animation) should play. Play rate still modifies this length. 
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Manually Specified Animation Length", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool m_ManuallySpecifyAnimationLength;
-
-	/* If true, we'll treat a manually specified length as an interrupt - so normal rules for stopping, clearing the queue, etc apply. */
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Manual Length Is Interrupt", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool m_ManualLengthIsInterrupt;
-
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Stop Animation On BranchSegment", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool bStopAnimationOnBranch = false;
-
-	/* A String identifier you can use to identify this specific task in the Ability blueprint, when GetSkeletalMeshComponentForActor is called on the Ability. */
-	UPROPERTY(EditAnywhere, Category = "Animation|Dynamic", meta = (DisplayName = "Event Name"))
-	FName m_EventName;
-	
-	/* If true, in a networked game, the animation will be played on the server. 
-	*  You should only use this if you have collision queries that rely on bone positions
-	*  or animation velocities.
-	*/
-	UPROPERTY(EditAnywhere, Category = "Network", meta=(DisplayName="Play On Server", EditCondition = "m_AnimationAsset!=nullptr"))
-	bool m_PlayOnServer;
-
-	/* If true, we'll treat a manually specified length as an interrupt - so normal rules for stopping, clearing the queue, etc apply. */
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Override Visibility Based Anim Tick"))
-	bool m_OverrideVisibilityBasedAnimTick;
-	
-	/* If true, we'll treat a manually specified length as an interrupt - so normal rules for stopping, clearing the queue, etc apply. */
-	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "New Visibility Based Anim Tick", EditCondition = "m_OverrideVisibilityBasedAnimTick", EditConditionHides))
-	EVisibilityBasedAnimTickOption m_VisibilityBasedAnimTick;
-};
-
-#undef LOCTEXT_NAMESPACE
+﻿// Copyright (c) Extra Life Studios, LLC. All rights reserved.
+
+#pragma once
+
+#include "UnLuaInterface.h"
+#include "ableAbilityTypes.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "IAbleAbilityTask.h"
+#include "UObject/ObjectMacros.h"
+
+#include "ablePlayAnimationTask.generated.h"
+
+#define LOCTEXT_NAMESPACE "AbleAbilityTask"
+
+class UAnimInstance;
+class UAnimMontage;
+class UAnimSingleNodeInstance;
+class UAnimationAsset;
+class UAbleAbility;
+class UAbleAbilityComponent;
+class UAbleAbilityContext;
+struct FStreamableHandle;
+
+/* Components of a single target, resolved once when the Task starts. */
+USTRUCT()
+struct ABLECORESP_API FAblePlayAnimationTaskTarget
+{
+	GENERATED_BODY()
+public:
+	/* The Actor we affected. */
+	UPROPERTY()
+	TWeakObjectPtr<AActor> Actor;
+
+	/* The Skeletal Mesh Components we played on. */
+	UPROPERTY()
+	TArray<TWeakObjectPtr<USkeletalMeshComponent>> SkeletalComponents;
+
+	/* The Ability Component of the Actor (Ability Animation Node only). */
+	UPROPERTY()
+	TWeakObjectPtr<UAbleAbilityComponent> AbilityComponent;
+
+	/* The first Skeletal Mesh Component of the Actor (Override Visibility Based Anim Tick only). */
+	UPROPERTY()
+	TWeakObjectPtr<USkeletalMeshComponent> PrimarySkeletalComponent;
+};
+
+/* A Visibility Based Anim Tick override held by the Task. */
+USTRUCT()
+struct ABLECORESP_API FAblePlayAnimationTickOverride
+{
+	GENERATED_BODY()
+public:
+	/* Handle returned by UAbleAnimTickOverrideSubsystem::PushOverride. */
+	UPROPERTY()
+	int32 Handle = INDEX_NONE;
+
+	UPROPERTY()
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+};
+
+/* A Montage instance started by the Task. */
+USTRUCT()
+struct ABLECORESP_API FAblePlayAnimationMontageEntry
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY()
+	TWeakObjectPtr<UAnimInstance> AnimInstance;
+
+	UPROPERTY()
+	TWeakObjectPtr<UAnimMontage> Montage;
+
+	/* FAnimMontageInstance::GetInstanceID of the instance we started. */
+	UPROPERTY()
+	int32 MontageInstanceID = INDEX_NONE;
+
+	/* Montage position the Task time is measured from (the start of the Section we played, or Time To Start At). */
+	UPROPERTY()
+	float StartPosition = 0.0f;
+};
+
+/* Scratchpad for our Task. */
+UCLASS(Transient)
+class ABLECORESP_API UAblePlayAnimationTaskScratchPad : public UAbleAbilityTaskScratchPad
+{
+	GENERATED_BODY()
+public:
+	UAblePlayAnimationTaskScratchPad();
+	virtual ~UAblePlayAnimationTaskScratchPad();
+
+	/* The Ability Components of all the actors we affected. */
+	UPROPERTY(transient)
+	TArray<TWeakObjectPtr<UAbleAbilityComponent>> AbilityComponents;
+
+	/* The Skeletal Mesh Components of all the actors we affected (Single Node only). */
+	UPROPERTY(transient)
+	TArray<TWeakObjectPtr<USkeletalMeshComponent>> SingleNodeSkeletalComponents;
+
+	/* The Visibility Based Anim Tick overrides we requested from UAbleAnimTickOverrideSubsystem. */
+	UPROPERTY(transient)
+	TArray<FAblePlayAnimationTickOverride> AnimTickOverrides;
+
+	UPROPERTY()
+	TWeakObjectPtr<UAnimMontage> CurrentAnimMontage;
+
+	/* The targets we played on, with their components. */
+	UPROPERTY(transient)
+	TArray<FAblePlayAnimationTaskTarget> Targets;
+
+	/* The Montage instances we started, so play rate changes can go straight to them. */
+	UPROPERTY(transient)
+	TArray<FAblePlayAnimationMontageEntry> PlayingMontages;
+
+	/* The Single Node instances we started, so play rate changes can go straight to them. */
+	UPROPERTY(transient)
+	TArray<TWeakObjectPtr<UAnimSingleNodeInstance>> SingleNodeInstances;
+
+	/* Async load of the Animation while sync loads are disabled. Released once it completes or the Task ends. */
+	TSharedPtr<FStreamableHandle> PendingLoadHandle;
+
+	/* Moves every instance we started to the given Task time in one pass, no Montage or Section lookups. */
+	void SeekTrackedInstances(float TaskTime);
+
+	/* Sets the play rate of every instance we started in one pass, anything that has ended or been replaced since is skipped. */
+	void SetTrackedPlayRate(float PlayRate);
+};
+
+/* Every soft Animation reference used by the Play Animation Tasks of an Ability.
+*  UAblePlayAnimationPreloadSubsystem streams it in when the Ability is granted/equipped so the Tasks never have to load on the Game Thread.
+*  The assets stay resident for as long as the manifest holds its handle. */
+struct ABLECORESP_API FAblePlayAnimationPreloadManifest
+{
+	/* Collects the Animation references of all Play Animation Tasks in the Ability. */
+	void Gather(const UAbleAbility& Ability);
+
+	/* Streams the gathered Animations in asynchronously. */
+	void RequestAsyncLoad();
+
+	/* Releases the streamed Animations. */
+	void Release();
+
+	/* Returns true once every gathered Animation is resident. */
+	bool IsLoaded() const;
+
+	TArray<FSoftObjectPath> Assets;
+
+	TSharedPtr<FStreamableHandle> Handle;
+};
+
+UENUM(BlueprintType)
+enum EAblePlayAnimationTaskAnimMode
+{
+	SingleNode UMETA(DisplayName="Single Node"),
+	AbilityAnimationNode UMETA(DisplayName = "Ability Animation Node"),
+	DynamicMontage UMETA(DisplayName = "Dynamic Montage")
+};
+
+UENUM(BlueprintType)
+enum EAblePlayAnimationServerMode
+{
+	ServerFullPose UMETA(DisplayName = "Full Pose"),
+	ServerTimelineOnly UMETA(DisplayName = "Timeline Only")
+};
+
+UCLASS()
+class ABLECORESP_API UAblePlayAnimationTask : public UAbleAbilityTask, public IUnLuaInterface
+{
+	GENERATED_BODY()
+
+protected:
+	virtual FString GetModuleName_Implementation() const override;
+
+public:
+	UAblePlayAnimationTask(const FObjectInitializer& ObjectInitializer);
+	virtual ~UAblePlayAnimationTask();
+
+	/* Start our Task. */
+	virtual void OnTaskStart(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskStart"))
+	void OnTaskStartBP(const UAbleAbilityContext* Context) const;
+
+	/* Streams the Animation in for this cast and starts it late, at the Task time reached, once it arrives. */
+	void RequestAnimationLoad(const UAbleAbilityContext* Context) const;
+	
+	/* End our Task. */
+	virtual void OnTaskEnd(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const EAbleAbilityTaskResult result) const override;
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "OnTaskEnd"))
+	void OnTaskEndBP(const UAbleAbilityContext* Context, const EAbleAbilityTaskResult result) const;
+
+	/* Check if our Task is finished. */
+	virtual bool IsDone(const TWeakObjectPtr<const UAbleAbilityContext>& Context) const override;
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "IsDone"))
+	bool IsDoneBP(const UAbleAbilityContext* Context) const;
+
+	/* Returns the End time of our Task. */
+	virtual float GetEndTime() const override;
+
+	/* Bakes the Animation length so GetEndTime doesn't need to touch the asset at runtime. */
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+	/* Returns which realm this Task belongs to. */
+	virtual EAbleAbilityTaskRealm GetTaskRealm() const override { return GetTaskRealmBP(); }
+
+	UFUNCTION(BlueprintNativeEvent, meta = (DisplayName = "GetTaskRealm"))
+	EAbleAbilityTaskRealm GetTaskRealmBP() const;
+
+	/* Creates the Scratchpad for our Task. */
+	virtual UAbleAbilityTaskScratchPad* CreateScratchPad(const TWeakObjectPtr<UAbleAbilityContext>& Context) const;
+
+	/* Returns the Profiler Stat ID for our Task. */
+	virtual TStatId GetStatId() const override;
+
+	/* Called when our Time has been set. */
+	virtual void OnAbilityTimeSet(const TWeakObjectPtr<const UAbleAbilityContext>& Context) override;
+
+	/* Setup Dynamic Binding. */
+	virtual void BindDynamicDelegates( UAbleAbility* Ability ) override;
+
+#if WITH_EDITOR
+	/* Returns the category of our Task. */
+	virtual FText GetTaskCategory() const override { return LOCTEXT("AblePlayAnimationTaskCategory", "Animation"); }
+	
+	/* Returns the name of our Task. */
+	virtual FText GetTaskName() const override { return LOCTEXT("AblePlayAnimationTask", "Play Animation"); }
+
+	/* Returns the dynamic, descriptive name of our Task. */
+	virtual FText GetDescriptiveTaskName() const override;
+	
+	/* Returns the Rich Text description, with mark ups. */
+	virtual FText GetRichTextTaskSummary() const override;
+
+	/* Returns the description of our Task. */
+	virtual FText GetTaskDescription() const override { return LOCTEXT("AblePlayAnimationTaskDesc", "Plays an Animation asset (currently only Animation Montage and Animation Segments are supported)."); }
+	
+	/* Returns the color of our Task. */
+	virtual FLinearColor GetTaskColor() const override { return FLinearColor(177.0f / 255.0f, 44.0f / 255.0f, 87.0f / 255.0f); } // Light Blue
+	
+	/* Returns the estimated runtime cost of our Task. */
+	virtual float GetEstimatedTaskCost() const override { return ABLETASK_EST_SYNC; }
+
+	/* Returns how to display the End time of our Task. */
+	virtual EVisibility ShowEndTime() const override { return m_ManuallySpecifyAnimationLength ? EVisibility::Visible : EVisibility::Hidden; } // Hidden = Read only (it's still using space in the layout, so might as well display it).
+
+    EDataValidationResult IsTaskDataValid(const UAbleAbility* AbilityContext, const FText& AssetName, TArray<FText>& ValidationErrors) override;
+#endif
+	/* Returns the Animation Asset. Uses the preloaded asset if it is resident, otherwise falls back to a (counted) synchronous load.
+	*  Null if it is not resident and sync loads are disabled. */
+	const UAnimationAsset* GetAnimationAsset() const;
+
+	/* Appends the soft Animation references of this Task, used by FAblePlayAnimationPreloadManifest. */
+	void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const;
+
+	FORCEINLINE TSoftObjectPtr<UAnimationAsset> GetSoftAnimationAsset() const { return m_AnimationAsset; }
+	
+    /* Returns the Ability State Name. */
+    FORCEINLINE const FName& GetAnimationMontageSectionName() const { return m_AnimationMontageSection; }
+
+	/* Sets the Animation Asset. */
+	void SetAnimationAsset(UAnimationAsset* Animation);
+
+	/* Returns true if the baked Animation length matches our current Animation and Montage Section. */
+	bool HasBakedAnimationLength() const;
+
+	/* Returns the start time of the Section in the Montage, from the baked table when it matches our Animation. */
+	float GetSectionStartTime(const UAnimMontage& Montage, const FName& Section) const;
+
+	/* Returns the Animation Mode. */
+	FORCEINLINE EAblePlayAnimationTaskAnimMode GetAnimationMode() const { return m_AnimationMode.GetValue(); }
+	
+	/* Returns the State Machine Name. */
+	FORCEINLINE const FName& GetStateMachineName() const { return m_StateMachineName; }
+	
+	/* Returns the Ability State Name. */
+	FORCEINLINE const FName& GetAbilityStateName() const { return m_AbilityStateName; }
+
+	/* Sets animation mode. */
+	FORCEINLINE void SetAnimationMode(EAblePlayAnimationTaskAnimMode Mode) { m_AnimationMode = Mode; }
+
+	/* Sets is loop. */
+	FORCEINLINE void SetLoop(bool Loop) { m_Loop = Loop; }
+
+	/* Sets is reset animation state on end. */
+	FORCEINLINE void SetResetAnimationStateOnEnd(bool Reset) { m_ResetAnimationStateOnEnd = Reset; }
+
+	/* Sets dynamic montage blend. */
+	FORCEINLINE void SetDynamicMontageBlend(const FAbleBlendTimes& BlendTimes) { m_DynamicMontageBlend = BlendTimes; }
+
+	/* Sets slot name. */
+	FORCEINLINE void SetSlotName(const FName& SlotName) { m_SlotName = SlotName; }
+
+	/* Sets time to start montage at. */
+	FORCEINLINE void SetTimeToStartMontageAt(float Time) { m_TimeToStartMontageAt = Time; }
+
+	/* Sets blend out trigger time. */
+	FORCEINLINE void SetBlendOutTriggerTime(float Time) { m_BlendOutTriggerTime = Time; }
+
+	/* Sets number of loops. */
+	FORCEINLINE void SetNumberOfLoops(int32 Loops) { m_NumberOfLoops = Loops; }
+
+	/* Sets stop all montages. */
+	FORCEINLINE void SetStopAllMontages(bool Stop) { m_StopAllMontages = Stop; }
+
+	virtual void OnAbilityPlayRateChanged(const UAbleAbilityContext* Context, float NewPlayRate) override;
+
+	/* Evaluates the bones of a mesh that is playing in Timeline Only server mode. Collision queries should call this before reading sockets, it does nothing for any other mesh. */
+	static void EvaluateServerPose(USkeletalMeshComponent* MeshComponent);
+
+	/* Evaluates the Timeline Only meshes of the Actors a socket Location resolves against. Call before FAbleAbilityTargetTypeLocation::GetTransform in collision queries. */
+	UFUNCTION(BlueprintCallable, Category = "Able|Animation")
+	static void EvaluateServerPoseForLocation(const UAbleAbilityContext* Context, const FAbleAbilityTargetTypeLocation& Location);
+
+protected:
+	/* Helper method to clean up code a bit. This method does the actual PlayAnimation/Montage_Play/etc call.*/
+	void PlayAnimation(const TWeakObjectPtr<const UAbleAbilityContext>& Context, const UAnimationAsset* AnimationAsset, const FName& MontageSection, AActor& TargetActor, UAblePlayAnimationTaskScratchPad& ScratchPad, USkeletalMeshComponent& SkeletalMeshComponent, UAbleAbilityComponent* AbilityComponent, float PlayRate) const;
+
+	/* Records the instance of a Montage we just started on the Anim Instance. */
+	static void TrackMontage(UAblePlayAnimationTaskScratchPad& ScratchPad, UAnimInstance& AnimInstance, UAnimMontage* Montage, float StartPosition);
+	
+	virtual UAnimMontage* PlayMontageBySequence(UAnimInstance* Instance, UAnimSequenceBase* Asset, FName SlotNodeName, float BlendInTime = 0.25f, float BlendOutTime = 0.25f, float InPlayRate = 1.f, int32 LoopCount = 1, float BlendOutTriggerTime = -1.f, float InTimeToStartMontageAt = 0.f, bool bStopAllMontages = true, float Weight = 1.0f) const;
+	
+	/* Finds the Skeletal Mesh Components (and Ability Component) the Task plays on for the Actor. */
+	void ResolveTarget(const UAbleAbilityContext* Context, AActor& TargetActor, FAblePlayAnimationTaskTarget& Entry) const;
+
+	/* Plays the Animation on every component of a resolved target and requests its Visibility Based Anim Tick overrides. */
+	void PlayTarget(const UAbleAbilityContext* Context, const UAnimationAsset* AnimationAsset, const FName& MontageSection, UAblePlayAnimationTaskScratchPad& ScratchPad, const FAblePlayAnimationTaskTarget& Entry, float PlayRate, bool bServerTimelineOnly) const;
+
+	/* Requests a Visibility Based Anim Tick override for the duration of the Task. */
+	void PushAnimTickOverride(const UAbleAbilityContext* Context, UAblePlayAnimationTaskScratchPad& ScratchPad, USkeletalMeshComponent& MeshComponent, EVisibilityBasedAnimTickOption Option) const;
+
+	/* Releases every override requested by PushAnimTickOverride. */
+	void ReleaseAnimTickOverrides(const UAbleAbilityContext* Context, UAblePlayAnimationTaskScratchPad& ScratchPad) const;
+
+	/* Returns the length (at a Play Rate of 1.0) of the Animation or Montage Section, or a negative value if there is no valid Animation. */
+	float CalculateAnimationLength(const UAnimationAsset* AnimationAsset) const;
+
+	/* Helper method to find the AbilityAnimGraph Node, if it exists. */
+	struct FAnimNode_SPAbilityAnimPlayer* GetAbilityAnimGraphNode(const TWeakObjectPtr<const UAbleAbilityContext>& Context, USkeletalMeshComponent* MeshComponent) const;
+	
+	// The Animation to play.
+    UPROPERTY(EditAnywhere, Category="Animation", meta = (DisplayName = "Animation", AbleBindableProperty, AbleDefaultBinding = "OnGetAnimationAssetBP", AllowedClasses = "AnimMontage,AnimSequence"))
+	TSoftObjectPtr<UAnimationAsset> m_AnimationAsset;
+
+	UPROPERTY()
+	FGetAbleAnimation m_AnimationAssetDelegate;
+
+	/* The animation montage section to jump to if using Dynamic Montages. */
+    UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Montage Section", AbleBindableProperty))
+    FName m_AnimationMontageSection;
+
+	UPROPERTY()
+	FGetAbleName m_AnimationMontageSectionDelegate;
+
+	/* If set, Jump to this montage section when the Task ends, if using Dynamic Montages. Set it to Name_None to disable this feature.*/
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Montage Section on End", AbleBindableProperty ))
+	FName m_OnEndAnimationMontageSection;
+
+	UPROPERTY()
+	FGetAbleName m_OnEndAnimationMontageSectionDelegate;
+
+	/* What mode to use for this task. 
+	*  Single Node - Plays the Animation as a Single Node Animation outside of the Animation Blueprint (if there is one).
+	*  Ability Animation Node - Plays the Animation using the Ability Animation Node within an Animation State Machine.
+	*  Dynamic Montage - Plays the Animation as a Dynamic Montage.
+	*/
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Animation Mode", EditCondition = "m_AnimationAsset!=nullptr"))
+	TEnumAsByte<EAblePlayAnimationTaskAnimMode> m_AnimationMode;
+
+	/* The name of the State Machine we should look for our Ability State in.*/
+	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "State Machine Name", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
+	FName m_StateMachineName;
+
+	UPROPERTY()
+	FGetAbleName m_StateMachineNameDelegate;
+
+	/* The name of the State that contains the Ability Animation Player Node*/
+	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "Ability State Name", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
+	FName m_AbilityStateName;
+
+	UPROPERTY()
+	FGetAbleName m_AbilityStateNameDelegate;
+
+	/* If the node is already playing an animation, this is the blend used transition to this animation.*/
+	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "Blend In", EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
+	FAlphaBlend m_BlendIn;
+
+	/* If the node doesn't have any more animations to play, this is the blend used transition out of this animation. NOTE: Currently unused.*/
+	UPROPERTY(EditAnywhere, Category = "Ability Node", meta = (DisplayName = "Blend Out", EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
+	FAlphaBlend m_BlendOut;
+
+	// Whether or not to loop the animation.
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Loop", EditCondition="m_AnimationAsset!=nullptr"))
+	bool m_Loop;
+
+	// Blend times to use when playing the animation as a dynamic montage.
+	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Play Blend", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
+	FAbleBlendTimes m_DynamicMontageBlend;
+
+	UPROPERTY()
+	FGetAbleBlendTimes m_DynamicMontageBlendDelegate;
+
+	// Slot Name to use for the Sequence when playing as a dynamic montage.
+	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Slot Name", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
+	FName m_SlotName;
+
+	UPROPERTY()
+	FGetAbleName m_SlotNameDelegate;
+
+	// Used when attempting to play a Slot Animation Asset as a Dynamic Montage, or playing a Montage Asset (including as a Single Node Animation). Offsets the starting time of the animation.
+	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Time To Start At", AbleBindableProperty, EditCondition = "m_AnimationMode != EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
+	float m_TimeToStartMontageAt;
+
+	UPROPERTY()
+	FGetAbleFloat m_TimeToStartMontageAtDelegate;
+
+	// Used when attempting to play a Slot Animation Asset as a Dynamic Montage. Offsets the Blend out time. 
+	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Blend Out Trigger Time", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
+	float m_BlendOutTriggerTime;
+
+	UPROPERTY()
+	FGetAbleFloat m_BlendOutTriggerTimeDelegate;
+
+	// Used when attempting to play a Slot Animation Asset as a Dynamic Montage. Loops the Animation N times.
+	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Number Of Loops", AbleBindableProperty, EditCondition = "m_AnimationMode == EAblePlayAnimationTaskAnimMode::DynamicMontage"))
+	int32 m_NumberOfLoops;
+
+	UPROPERTY()
+	FGetAbleInt m_NumberOfLoopsDelegate;
+
+	// Used when attempting to play a Montage Asset (including as a Single Node Animation). Stops all existing montages.
+	UPROPERTY(EditAnywhere, Category = "Dynamic Montage", meta = (DisplayName = "Stop All Montages", AbleBindableProperty, EditCondition = "m_AnimationMode != EAblePlayAnimationTaskAnimMode::AbilityAnimationNode"))
+	bool m_StopAllMontages;
+
+	UPROPERTY()
+	FGetAbleBool m_StopAllMontagesDelegate;
+
+	// Animation Play Rate
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Play Rate", AbleBindableProperty, EditCondition = "m_AnimationAsset!=nullptr"))
+	float m_PlayRate;
+
+	UPROPERTY()
+	FGetAbleFloat m_PlayRateDelegate;
+
+	// If true, we scale our Animation Play Rate by what our Ability Play Rate is. So, if your Ability Play Rate is 2.0, the animation play rate is multiplied by that same value.
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Scale With Ability Play Rate", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_ScaleWithAbilityPlayRate;
+
+	// If true, stop the current playing animation mid blend if the owning Ability is interrupted. Only applies when Animation Mode is set to Ability Animation Node.
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Stop on Interrupt", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_StopAnimationOnInterrupt;
+
+	// If true, any queued up (using the Ability Animation Node) animations will be removed as well. 
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Clear Queued Animation On Interrupt", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_ClearQueuedAnimationOnInterrupt;
+
+	// If true, Able will try to reset you into whatever Animation State you were in when the Task started (e.g., Single Instance vs Animation Blueprint).
+	// You can disable this if you see it causing issues, as this does reset the animation instance time when it's called.
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Reset Animation State On End", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_ResetAnimationStateOnEnd;
+
+	// If true, you can tell Able how long this task (and thus the animation) should play. Play rate still modifies this length. 
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Manually Specified Animation Length", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_ManuallySpecifyAnimationLength;
+
+	/* If true, we'll treat a manually specified length as an interrupt - so normal rules for stopping, clearing the queue, etc apply. */
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Manual Length Is Interrupt", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_ManualLengthIsInterrupt;
+
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Stop Animation On BranchSegment", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool bStopAnimationOnBranch = false;
+
+	/* A String identifier you can use to identify this specific task in the Ability blueprint, when GetSkeletalMeshComponentForActor is called on the Ability. */
+	UPROPERTY(EditAnywhere, Category = "Animation|Dynamic", meta = (DisplayName = "Event Name"))
+	FName m_EventName;
+	
+	/* If true, in a networked game, the animation will be played on the server. 
+	*  You should only use this if you have collision queries that rely on bone positions
+	*  or animation velocities.
+	*/
+	UPROPERTY(EditAnywhere, Category = "Network", meta=(DisplayName="Play On Server", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_PlayOnServer;
+
+	/* How a dedicated server plays Montages when Play On Server is set.
+	*  Full Pose - Ticks and evaluates the pose, same as a client.
+	*  Timeline Only - Only advances the Montage (position, sections, notifies, root motion) from the asset data. Bones are evaluated on demand when a collision query resolves a socket Location
+	*  through EvaluateServerPoseForLocation (spatial targeting rules, lasers), at most once per frame. Stock Collision Query, Collision Sweep and Raycast Tasks read sockets
+	*  without it, so Abilities that have one fail validation and play with Full Pose.
+	*/
+	UPROPERTY(EditAnywhere, Category = "Network", meta = (DisplayName = "Server Animation Mode", EditCondition = "m_PlayOnServer"))
+	TEnumAsByte<EAblePlayAnimationServerMode> m_ServerAnimationMode;
+
+	/* If true, we'll treat a manually specified length as an interrupt - so normal rules for stopping, clearing the queue, etc apply. */
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Override Visibility Based Anim Tick"))
+	bool m_OverrideVisibilityBasedAnimTick;
+	
+	/* If true, we'll treat a manually specified length as an interrupt - so normal rules for stopping, clearing the queue, etc apply. */
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "New Visibility Based Anim Tick", EditCondition = "m_OverrideVisibilityBasedAnimTick", EditConditionHides))
+	EVisibilityBasedAnimTickOption m_VisibilityBasedAnimTick;
+
+	/* When several Tasks override the same mesh, the highest priority wins (the most recent one on ties). */
+	UPROPERTY(EditAnywhere, Category = "Animation", meta = (DisplayName = "Visibility Based Anim Tick Priority", EditCondition = "m_OverrideVisibilityBasedAnimTick", EditConditionHides))
+	int32 m_VisibilityBasedAnimTickPriority;
+
+	/* If true, the components of every target are resolved first and then played on in a single pass. The components found for an Actor are cached across casts
+	*  of this Task and only resolved again once one of them is gone, so only enable it when GetSkeletalMeshComponentForActor returns the same mesh on every cast. */
+	UPROPERTY(EditAnywhere, Category = "Optimization", meta = (DisplayName = "Batch Targets", EditCondition = "m_AnimationAsset!=nullptr"))
+	bool m_BatchTargets;
+
+	/* Length (at a Play Rate of 1.0) of the Animation / Montage Section, baked on save and cook. Negative if not baked. */
+	UPROPERTY()
+	float m_BakedAnimationLength;
+
+	/* The Animation m_BakedAnimationLength was baked from. */
+	UPROPERTY()
+	FSoftObjectPath m_BakedAnimationPath;
+
+	/* The Montage Section m_BakedAnimationLength was baked from. */
+	UPROPERTY()
+	FName m_BakedAnimationSection;
+
+	/* Start time of every Section of the Montage at m_BakedAnimationPath, baked on save and cook. */
+	UPROPERTY()
+	TMap<FName, float> m_BakedSectionStartTimes;
+};
+
+#undef LOCTEXT_NAMESPACE